@@ -21,6 +21,7 @@
 
 /* Private includes ----------------------------------------------------------*/
 /* USER CODE BEGIN Includes */
+#include "shared.h"
 #include "waves.h"
 /* USER CODE END Includes */
 
@@ -36,6 +37,11 @@
 #define HSEM_ID_0 (0U) /* HW semaphore 0*/
 #endif
 
+// Released at the start of every period of the generated signal to notify the CM7
+#ifndef HSEM_ID_1
+#define HSEM_ID_1 (1U) /* HW semaphore 1*/
+#endif
+
 /* USER CODE END PD */
 
 /* Private macro -------------------------------------------------------------*/
@@ -61,10 +67,7 @@ static void MX_DAC1_Init(void);
 
 /* Private user code ---------------------------------------------------------*/
 /* USER CODE BEGIN 0 */
-struct _shared {
-	uint32_t generator_index;
-};
-volatile struct _shared * const shared_data = (struct _shared *)0x38001000;
+volatile struct _shared * const shared_data = (struct _shared *)SHARED_DATA_ADDRESS;
 
 /* USER CODE END 0 */
 
@@ -128,6 +131,12 @@ int main(void)
     if (HAL_GetTick() - freq >= 5) {
         ind++;
         freq = HAL_GetTick();
+
+        // Sync output used by the CM7 as trigger source
+        if (ind % WAVES_SIZE == 0) {
+            HAL_HSEM_FastTake(HSEM_ID_1);
+            HAL_HSEM_Release(HSEM_ID_1, 0);
+        }
     }
     /* USER CODE END WHILE */
 
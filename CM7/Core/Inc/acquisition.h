@@ -0,0 +1,310 @@
+/**
+ * @file acquisition.h
+ * @brief Continuous acquisition of the oscilloscope channels
+ *
+ * @details The two ADCs convert the channels simultaneously (or the first channel
+ * interleaved) and never stop, the DMA writes the samples into a circular buffer
+ * which is consumed in halves: while one half is processed the other is filled
+ * The DMA interrupt only queues the completed halves, which are processed later
+ * with the lowest priority so that the interrupt latency stays bounded
+ *
+ * @date Oct 16, 2026
+ * @author Antonio Gelain [antonio.gelain@studenti.unitn.it]
+ */
+
+#ifndef ACQUISITION_H
+#define ACQUISITION_H
+
+#include "main.h"
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+#include "chart_handler.h"
+
+/** @brief Maximum number of samples of each half of the DMA circular buffer */
+#define ACQUISITION_BLOCK_SAMPLE_COUNT (CHART_SAMPLE_COUNT / 2U)
+
+/** @brief Minimum number of samples of each half of the DMA circular buffer */
+#define ACQUISITION_MIN_BLOCK_SAMPLE_COUNT (8U)
+
+/** @brief Time after which a block should be completed at slow timebases in us */
+#define ACQUISITION_BLOCK_TARGET_TIME (20000.f)
+
+/** @brief Time after which the elapsed time is measured with the system tick instead of the cycle counter in ms */
+#define ACQUISITION_MAX_CYCLE_TIME (1000U)
+
+/**
+ * @brief Number of samples taken for each value of the chart when the conversions are paced by the timer
+ *
+ * @details In peak detect and high resolution modes the samples are taken at the maximum rate of the profile instead
+ */
+#define ACQUISITION_SAMPLES_PER_VALUE (4U)
+
+/** @brief ADC input channels connected to the oscilloscope channels */
+#define ACQUISITION_CH1_ADC_CHANNEL (ADC_CHANNEL_0)
+#define ACQUISITION_CH2_ADC_CHANNEL (ADC_CHANNEL_1)
+
+/** @brief Maximum time to wait for the calibration samples in ms */
+#define ACQUISITION_CALIBRATION_TIMEOUT (100U)
+
+/** @brief Number of times the circular buffer is filled to average the calibration samples */
+#define ACQUISITION_CALIBRATION_BUFFER_COUNT (16U)
+
+/** @brief Minimum distance between the two calibration levels needed to measure the gain mismatch */
+#define ACQUISITION_CALIBRATION_MIN_SPAN ((float)(1U << ADC_RESOLUTION) / 2.f)
+
+/** @brief Maximum number of external trigger events waiting for their block (must be a power of 2) */
+#define ACQUISITION_EVENT_QUEUE_LENGTH (16U)
+
+/**
+ * @brief Type definition for the way the conversions are started
+ *
+ * @details
+ *     - ACQUISITION_PACING_TIMER each conversion is triggered by the timer at a rate chosen from the timebase
+ *     - ACQUISITION_PACING_FREE_RUNNING the ADC converts continuously as fast as it can
+ *       and the sample period is given by the conversion cycles of the profile
+ */
+typedef enum {
+    ACQUISITION_PACING_TIMER,
+    ACQUISITION_PACING_FREE_RUNNING,
+    ACQUISITION_PACING_COUNT
+} AcquisitionPacing;
+
+/**
+ * @brief Type definition for the way the two ADCs are combined
+ *
+ * @details
+ *     - ACQUISITION_MODE_SIMULTANEOUS each ADC converts a different channel at the same time
+ *     - ACQUISITION_MODE_INTERLEAVED both ADCs convert the first channel half a conversion apart
+ *       doubling its sample rate, it is used when the second channel is disabled at the
+ *       fastest timebases (or with the free running pacing)
+ */
+typedef enum {
+    ACQUISITION_MODE_SIMULTANEOUS,
+    ACQUISITION_MODE_INTERLEAVED,
+    ACQUISITION_MODE_COUNT
+} AcquisitionMode;
+
+/**
+ * @brief Type definition for the input levels used to calibrate the ADCs
+ *
+ * @details
+ *     - ACQUISITION_CALIBRATION_LOW the input is near the bottom of the range
+ *     - ACQUISITION_CALIBRATION_HIGH the input is near the top of the range
+ */
+typedef enum {
+    ACQUISITION_CALIBRATION_LOW,
+    ACQUISITION_CALIBRATION_HIGH,
+    ACQUISITION_CALIBRATION_COUNT
+} AcquisitionCalibrationPoint;
+
+/**
+ * @brief Configuration of the ADCs used for a range of time scales
+ *
+ * @details The resolution, the oversampling and the shifts are chosen so that
+ * the samples are always ADC_RESOLUTION bits wide
+ *
+ * @param min_x_scale The minimum time scale per division for the profile in us
+ * @param resolution The ADC resolution (ADC_RESOLUTION_xB)
+ * @param sampling_time The sampling time of the channels (ADC_SAMPLETIME_xCYCLES_5)
+ * @param conversion_cycles The number of ADC clock cycles of each sample, counting every oversampled conversion
+ * @param oversampling_ratio The number of conversions summed for each sample (1 to disable)
+ * @param right_shift The right shift of the oversampled sum (ADC_RIGHTBITSHIFT_x)
+ * @param left_shift The left shift of the samples (ADC_LEFTBITSHIFT_x)
+ * @param interleaved_delay The delay of the slave conversion in interleaved mode,
+ *     exactly half of the conversion cycles (ADC_TWOSAMPLINGDELAY_xCYCLES)
+ * @param min_sample_period The minimum time between two samples in us
+ */
+typedef struct {
+    float min_x_scale; // in us
+    uint32_t resolution;
+    uint32_t sampling_time;
+    uint32_t conversion_cycles;
+    uint32_t oversampling_ratio;
+    uint32_t right_shift;
+    uint32_t left_shift;
+    uint32_t interleaved_delay;
+    float min_sample_period; // in us
+} AcquisitionProfile;
+
+/**
+ * @brief Initialize the acquisition handler
+ *
+ * @details The ADCs must be configured in dual regular simultaneous mode with the
+ * master DMA enabled, the external trigger of the master ADC init structure is used
+ * as trigger source when the conversions are paced by the timer
+ *
+ * @param hadc The master ADC handler used to convert the first channel
+ * @param hadc_slave The slave ADC handler used to convert the second channel
+ * @param htim_trigger The timer handler whose TRGO triggers each conversion
+ * @param chart_handler A pointer to the chart handler that receives the acquired blocks
+ *
+ * @return HAL_StatusTypeDef HAL_OK if everything was initialized correctly
+ */
+HAL_StatusTypeDef acquisition_init(
+    ADC_HandleTypeDef * hadc,
+    ADC_HandleTypeDef * hadc_slave,
+    TIM_HandleTypeDef * htim_trigger,
+    ChartHandler * chart_handler
+);
+
+/**
+ * @brief Start the continuous conversion of the channels
+ *
+ * @return HAL_StatusTypeDef HAL_OK if the conversion is started correctly
+ */
+HAL_StatusTypeDef acquisition_start(void);
+
+/**
+ * @brief Stop the conversion of the channels
+ *
+ * @return HAL_StatusTypeDef HAL_OK if the conversion is stopped correctly
+ */
+HAL_StatusTypeDef acquisition_stop(void);
+
+/**
+ * @brief Measure the offset and gain mismatch between the two ADCs at a single input level
+ *
+ * @details Both ADCs convert the first channel interleaved, so that their sampling never
+ * overlaps, and the mean of the samples of each ADC is compared; the correction is applied
+ * to the slave samples in interleaved mode
+ * The procedure is:
+ *     1. Connect the first channel to ground (or leave it at rest) and calibrate the low level,
+ *        this measures the offset with the current gain and is done at startup too
+ *     2. Connect the first channel to a level near the top of the range (e.g. the maximum of the
+ *        signal generator) and calibrate the high level, this measures the gain between the
+ *        two levels and the offset again
+ * @attention The input must be constant (or periodic) during each measurement and the two levels
+ * must be at least ACQUISITION_CALIBRATION_MIN_SPAN apart, otherwise the gain is not changed
+ *
+ * @param point The level of the input
+ *
+ * @return HAL_StatusTypeDef HAL_OK if the calibration was completed correctly
+ */
+HAL_StatusTypeDef acquisition_calibrate(AcquisitionCalibrationPoint point);
+
+/**
+ * @brief Get the way the conversions are started
+ *
+ * @return AcquisitionPacing The current pacing
+ */
+AcquisitionPacing acquisition_get_pacing(void);
+
+/**
+ * @brief Set the way the conversions are started
+ *
+ * @details The acquisition is restarted if it was running
+ *
+ * @param pacing The pacing to set
+ *
+ * @return HAL_StatusTypeDef HAL_OK if the ADC was configured correctly
+ */
+HAL_StatusTypeDef acquisition_set_pacing(AcquisitionPacing pacing);
+
+/**
+ * @brief Get the way the two ADCs are currently combined
+ *
+ * @return AcquisitionMode The current mode
+ */
+AcquisitionMode acquisition_get_mode(void);
+
+/**
+ * @brief Get the profile currently used to configure the ADCs
+ *
+ * @return const AcquisitionProfile * A pointer to the current profile
+ */
+const AcquisitionProfile * acquisition_get_profile(void);
+
+/**
+ * @brief Update the sample rate based on the time scale of the chart
+ *
+ * @details The profile and the mode are updated as well since they depend on the
+ * timebase and on the enabled channels
+ *
+ * @param x_scale The temporal scale per division in us
+ *
+ * @return HAL_StatusTypeDef HAL_OK if the sample rate was updated correctly
+ */
+HAL_StatusTypeDef acquisition_set_timebase(float x_scale);
+
+/**
+ * @brief Check if the analog watchdogs are used to find the trigger crossings
+ *
+ * @return bool True if the analog watchdogs are used, false otherwise
+ */
+bool acquisition_get_trigger_watchdog(void);
+
+/**
+ * @brief Use the analog watchdogs of the ADCs to find the blocks that can contain
+ * a trigger crossing, the other blocks are not searched by the chart handler
+ *
+ * @details The watchdogs are used only by the profiles without oversampling
+ * and the acquisition is restarted if it was running
+ *
+ * @param enabled True to use the analog watchdogs, false to search every block
+ *
+ * @return HAL_StatusTypeDef HAL_OK if the ADCs were configured correctly
+ */
+HAL_StatusTypeDef acquisition_set_trigger_watchdog(bool enabled);
+
+/**
+ * @brief Program the analog watchdogs with the current trigger levels of the chart handler
+ *
+ * @details The thresholds are rewritten while the ADCs are converting, the acquisition
+ * is restarted only when the watchdogs have to be enabled or disabled
+ *
+ * @return HAL_StatusTypeDef HAL_OK if the ADCs were configured correctly
+ */
+HAL_StatusTypeDef acquisition_update_trigger_level(void);
+
+/**
+ * @brief Get the time between two consecutive samples
+ *
+ * @details The period is given by the timer or by the conversion cycles of the profile
+ * when the conversions are continuous
+ *
+ * @return float The sample period in us
+ */
+float acquisition_get_sample_period(void);
+
+/**
+ * @brief Get the number of blocks lost because they were overwritten by the DMA
+ * before (or while) being processed
+ *
+ * @return uint32_t The number of dropped blocks
+ */
+uint32_t acquisition_get_dropped_count(void);
+
+/**
+ * @brief Process the blocks completed by the DMA in the order they were acquired
+ * @attention This function should be called from the PendSV handler, which is
+ * requested by the DMA callbacks every time a block is completed
+ */
+void acquisition_routine(void);
+
+/**
+ * @brief Queue the first half of the circular buffer to be processed
+ * @attention This function should be called from the ADC half conversion complete callback
+ *
+ * @param hadc The ADC handler that generated the callback
+ */
+void acquisition_half_complete_callback(ADC_HandleTypeDef * hadc);
+
+/**
+ * @brief Queue the second half of the circular buffer to be processed
+ * @attention This function should be called from the ADC conversion complete callback
+ *
+ * @param hadc The ADC handler that generated the callback
+ */
+void acquisition_complete_callback(ADC_HandleTypeDef * hadc);
+
+/**
+ * @brief Timestamp an external trigger event so that it is placed inside its block
+ * @attention This function should be called from an interrupt with a higher priority
+ * than the PendSV handler, as soon as the event happens
+ */
+void acquisition_add_trigger_event(void);
+
+#endif  // ACQUISITION_H
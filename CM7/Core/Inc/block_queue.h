@@ -0,0 +1,98 @@
+/**
+ * @file block_queue.h
+ * @brief Lock-free queue of the blocks acquired by the DMA
+ *
+ * @details The queue has a single producer (the DMA interrupt) and a single consumer
+ * (the code that processes the blocks), each side only writes its own index so
+ * no critical section is needed
+ * It does not depend on any peripheral so it can be tested on the host as well
+ *
+ * @date Oct 16, 2026
+ * @author Antonio Gelain [antonio.gelain@studenti.unitn.it]
+ */
+
+#ifndef BLOCK_QUEUE_H
+#define BLOCK_QUEUE_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include <stdatomic.h>
+
+/** @brief Maximum number of descriptors inside the queue (must be a power of 2) */
+#define BLOCK_QUEUE_LENGTH (4U)
+
+/**
+ * @brief Type definition for the description of a block written by the DMA
+ *
+ * @details
+ *     - raw is the address of the first transfer of the block
+ *     - count is the number of transfers of the block
+ *     - timestamp is the cycle counter value of the core when the block was completed
+ *     - elapsed is the number of cycles since the previous block was completed
+ *     - time is the time when the block was completed since the acquisition was initialized in us
+ *     - sequence is the number of the block, used to know if it was overwritten
+ */
+typedef struct {
+    volatile uint16_t * raw;
+    size_t count;
+    uint32_t timestamp;
+    uint32_t elapsed;
+    double time; // in us
+    uint32_t sequence;
+} BlockQueueItem;
+
+/**
+ * @brief Type definition for the queue
+ *
+ * @details
+ *     - head is the index of the next item to write, only changed by the producer
+ *     - tail is the index of the next item to read, only changed by the consumer
+ *     - items is the circular buffer of the descriptors
+ */
+typedef struct {
+    atomic_size_t head;
+    atomic_size_t tail;
+    BlockQueueItem items[BLOCK_QUEUE_LENGTH];
+} BlockQueue;
+
+/**
+ * @brief Initialize an empty queue
+ * @attention Neither the producer nor the consumer should use the queue meanwhile
+ *
+ * @param queue A pointer to the queue
+ */
+void block_queue_init(BlockQueue * queue);
+
+/**
+ * @brief Append a descriptor to the queue
+ * @attention This function should only be called by the producer
+ *
+ * @param queue A pointer to the queue
+ * @param item A pointer to the descriptor to copy inside the queue
+ *
+ * @return bool True if the descriptor was added, false if the queue is full
+ */
+bool block_queue_push(BlockQueue * queue, const BlockQueueItem * item);
+
+/**
+ * @brief Remove the oldest descriptor from the queue
+ * @attention This function should only be called by the consumer
+ *
+ * @param queue A pointer to the queue
+ * @param item A pointer where the descriptor is copied
+ *
+ * @return bool True if a descriptor was removed, false if the queue is empty
+ */
+bool block_queue_pop(BlockQueue * queue, BlockQueueItem * item);
+
+/**
+ * @brief Check if the queue is empty
+ *
+ * @param queue A pointer to the queue
+ *
+ * @return bool True if there are no descriptors inside the queue, false otherwise
+ */
+bool block_queue_is_empty(BlockQueue * queue);
+
+#endif  // BLOCK_QUEUE_H
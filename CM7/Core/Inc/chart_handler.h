@@ -21,6 +21,35 @@
 /** @brief Maximum number of raw samples that the chart handler can handler */
 #define CHART_HANDLER_VALUES_COUNT (CHART_X_DIVISION_COUNT * CHART_HANDLER_VALUES_PER_DIVISION)
 
+/** @brief Maximum number of trigger crossings merged in a single equivalent-time frame */
+#define CHART_HANDLER_EQUIVALENT_TIME_MAX_ACQUISITIONS (256U)
+
+/** @brief Minimum, maximum and default number of frames averaged in average mode (powers of 2) */
+#define CHART_HANDLER_AVERAGE_MIN_COUNT (2U)
+#define CHART_HANDLER_AVERAGE_MAX_COUNT (256U)
+#define CHART_HANDLER_AVERAGE_DEFAULT_COUNT (16U)
+
+/** @brief Number of fractional bits of the average accumulators */
+#define CHART_HANDLER_AVERAGE_FRACTION_BITS (12U)
+
+/** @brief Segment view used to display every saved segment over each other */
+#define CHART_HANDLER_SEGMENT_OVERLAY (SIZE_MAX)
+
+/** @brief Number of low bits of the samples dropped to index the lookup table of the chart coordinates */
+#define CHART_HANDLER_LUT_SHIFT (2U)
+
+/** @brief Number of entries of the lookup table of the chart coordinates of a single channel */
+#define CHART_HANDLER_LUT_SIZE (1U << (ADC_RESOLUTION - CHART_HANDLER_LUT_SHIFT))
+
+/** @brief Chart coordinate of a value which is not displayed */
+#define CHART_HANDLER_POINT_NONE (INT16_MIN)
+
+/** @brief Maximum number of external trigger events inside a single block */
+#define CHART_HANDLER_BLOCK_MAX_EVENTS (8U)
+
+/** @brief Minimum time without trigger events after which the auto mode displays the signal anyway in us */
+#define CHART_HANDLER_TRIGGER_AUTO_TIMEOUT (100000.f)
+
 /** @brief Available channels of the oscilloscope */
 typedef enum {
     CHART_HANDLER_CHANNEL_1,
@@ -41,6 +70,138 @@ typedef enum {
     CHART_HANDLER_KNOB_COUNT
 } ChartHandlerKnobMode;
 
+/**
+ * @brief Type definition for the way the samples are reduced to the displayed values
+ *
+ * @details
+ *     - CHART_HANDLER_ACQUISITION_NORMAL a single sample is taken for each value
+ *     - CHART_HANDLER_ACQUISITION_PEAK_DETECT the minimum and maximum of all the samples
+ *       between two values are kept and drawn as a vertical span, so narrow glitches are
+ *       still visible at long time scales
+ *     - CHART_HANDLER_ACQUISITION_AVERAGE each displayed value is the exponential average
+ *       of the same value of the last frames, which reduces the noise of repetitive signals
+ *     - CHART_HANDLER_ACQUISITION_HIGH_RESOLUTION each value is the mean of all the samples
+ *       between two values, which reduces the noise and increases the effective resolution
+ *       of single acquisitions when the ADC takes many samples for each value
+ */
+typedef enum {
+    CHART_HANDLER_ACQUISITION_NORMAL,
+    CHART_HANDLER_ACQUISITION_PEAK_DETECT,
+    CHART_HANDLER_ACQUISITION_AVERAGE,
+    CHART_HANDLER_ACQUISITION_HIGH_RESOLUTION,
+    CHART_HANDLER_ACQUISITION_COUNT
+} ChartHandlerAcquisitionMode;
+
+/**
+ * @brief Type definition for the way the trigger starts a new frame
+ *
+ * @details
+ *     - CHART_HANDLER_TRIGGER_AUTO the signal is displayed anyway when no trigger event
+ *       is found before a timeout, so that it is always visible
+ *     - CHART_HANDLER_TRIGGER_NORMAL the signal is displayed only after a trigger event
+ *     - CHART_HANDLER_TRIGGER_SINGLE the channel is stopped after the first trigger event
+ */
+typedef enum {
+    CHART_HANDLER_TRIGGER_AUTO,
+    CHART_HANDLER_TRIGGER_NORMAL,
+    CHART_HANDLER_TRIGGER_SINGLE,
+    CHART_HANDLER_TRIGGER_COUNT
+} ChartHandlerTriggerMode;
+
+/**
+ * @brief Type definition for the kind of event searched by the trigger
+ *
+ * @details The polarity of every event is selected by the ascending or descending trigger
+ *     - CHART_HANDLER_TRIGGER_EDGE the signal crosses the trigger level
+ *     - CHART_HANDLER_TRIGGER_PULSE_WIDTH a pulse above (or below) the trigger level ends
+ *       and its width satisfies the time condition
+ *     - CHART_HANDLER_TRIGGER_GLITCH a pulse of any polarity is narrower than the lower time limit
+ *     - CHART_HANDLER_TRIGGER_RUNT a pulse crosses the trigger level and goes back
+ *       without crossing the second level
+ *     - CHART_HANDLER_TRIGGER_SLOPE the signal goes from the trigger level to the second
+ *       level and the time taken satisfies the time condition
+ */
+typedef enum {
+    CHART_HANDLER_TRIGGER_EDGE,
+    CHART_HANDLER_TRIGGER_PULSE_WIDTH,
+    CHART_HANDLER_TRIGGER_GLITCH,
+    CHART_HANDLER_TRIGGER_RUNT,
+    CHART_HANDLER_TRIGGER_SLOPE,
+    CHART_HANDLER_TRIGGER_TYPE_COUNT
+} ChartHandlerTriggerType;
+
+/**
+ * @brief Type definition for the time condition of the pulse width and slope triggers
+ *
+ * @details
+ *     - CHART_HANDLER_TRIGGER_LESS the time is shorter than the lower limit
+ *     - CHART_HANDLER_TRIGGER_GREATER the time is longer than the lower limit
+ *     - CHART_HANDLER_TRIGGER_RANGE the time is between the lower and the upper limits
+ */
+typedef enum {
+    CHART_HANDLER_TRIGGER_LESS,
+    CHART_HANDLER_TRIGGER_GREATER,
+    CHART_HANDLER_TRIGGER_RANGE,
+    CHART_HANDLER_TRIGGER_CONDITION_COUNT
+} ChartHandlerTriggerCondition;
+
+/**
+ * @brief Type definition for the signal searched for the trigger events
+ *
+ * @details Both channels are aligned on the events of the same source
+ *     - CHART_HANDLER_TRIGGER_SOURCE_CHANNEL_1 the samples of the first channel
+ *     - CHART_HANDLER_TRIGGER_SOURCE_CHANNEL_2 the samples of the second channel
+ *     - CHART_HANDLER_TRIGGER_SOURCE_EXTERNAL the rising edges of the external trigger input
+ *     - CHART_HANDLER_TRIGGER_SOURCE_GENERATOR the start of every period of the signal generator
+ */
+typedef enum {
+    CHART_HANDLER_TRIGGER_SOURCE_CHANNEL_1,
+    CHART_HANDLER_TRIGGER_SOURCE_CHANNEL_2,
+    CHART_HANDLER_TRIGGER_SOURCE_EXTERNAL,
+    CHART_HANDLER_TRIGGER_SOURCE_GENERATOR,
+    CHART_HANDLER_TRIGGER_SOURCE_COUNT
+} ChartHandlerTriggerSource;
+
+/**
+ * @brief Type definition for the state of the trigger of a single channel
+ *
+ * @details
+ *     - CHART_HANDLER_TRIGGER_STATE_PRE_TRIGGER the values before the trigger are taken
+ *     - CHART_HANDLER_TRIGGER_STATE_ARMED the samples are searched for a trigger event
+ *     - CHART_HANDLER_TRIGGER_STATE_TRIGGERED the values after the trigger are taken
+ */
+typedef enum {
+    CHART_HANDLER_TRIGGER_STATE_PRE_TRIGGER,
+    CHART_HANDLER_TRIGGER_STATE_ARMED,
+    CHART_HANDLER_TRIGGER_STATE_TRIGGERED
+} ChartHandlerTriggerState;
+
+/**
+ * @brief Block of raw samples acquired by the ADC
+ *
+ * @details The block is owned by the DMA so its content stays valid only until the DMA
+ * wraps around and starts writing it again
+ *
+ * @param raw The raw ADC samples of each channel
+ * @param stride The distance between two consecutive samples of the same channel
+ * @param count The number of samples of each channel inside the block
+ * @param time The time of the first sample since the acquisition was initialized in us
+ * @param time_per_sample The time between two consecutive samples in us
+ * @param crossing False only if the samples of the channel surely do not cross its trigger level
+ * @param events The index of the first sample taken after each external trigger event in ascending order
+ * @param event_count The number of external trigger events inside the block
+ */
+typedef struct {
+    volatile const uint16_t * raw[CHART_HANDLER_CHANNEL_COUNT];
+    size_t stride;
+    size_t count;
+    double time; // in us
+    float time_per_sample; // in us
+    bool crossing[CHART_HANDLER_CHANNEL_COUNT];
+    size_t events[CHART_HANDLER_BLOCK_MAX_EVENTS];
+    size_t event_count;
+} ChartHandlerBlock;
+
 /**
  * @brief Definition to the chart handler structure
  *
@@ -62,7 +223,12 @@ typedef enum {
  * @param ready Flag set to true when all the data is ready to be displayed
  * @param index The current index inside the raw data
  * @param raw The raw ADC data
- * @param data The converted with scale and offset applyed ready to be displayed
+ * @param raw_min The minimum of the raw ADC data between two values (peak detect only)
+ * @param raw_max The maximum of the raw ADC data between two values (peak detect only)
+ * @param average The averaged values in display order with CHART_HANDLER_AVERAGE_FRACTION_BITS
+ * fractional bits (average only)
+ * @param data The chart coordinates of the values with scale and offset applyed ready to be displayed
+ * @param data_min The chart coordinates of the minimum values ready to be displayed (peak detect only)
  */
 typedef struct {
     void * api;
@@ -80,14 +246,78 @@ typedef struct {
     // Trigger
     uint16_t trigger[CHART_HANDLER_CHANNEL_COUNT];
     bool ascending_trigger, descending_trigger;
-
-    // Index of the raw value that crossed the trigger
+    ChartHandlerTriggerMode trigger_mode;
+    ChartHandlerTriggerSource trigger_source;
+    uint16_t trigger_hysteresis; // in raw ADC units
+    float trigger_holdoff; // in us
+
+    // Position of the trigger on the chart and delay between the trigger and the displayed values
+    float trigger_position; // in % of the chart width
+    float trigger_delay; // in us
+
+    // Event searched by the trigger, time limits and second level of the runt and slope triggers
+    ChartHandlerTriggerType trigger_type;
+    ChartHandlerTriggerCondition trigger_condition;
+    float trigger_limit_low, trigger_limit_high; // in divisions of the time scale
+    uint16_t trigger_second[CHART_HANDLER_CHANNEL_COUNT];
+
+    // State of the pulse, glitch, runt and slope triggers: the signal is inside a pulse, it reached
+    // the second level, and the start of the pulse in samples from the start of the current block is known
+    bool trigger_inside[CHART_HANDLER_CHANNEL_COUNT];
+    bool trigger_crossed[CHART_HANDLER_CHANNEL_COUNT];
+    bool trigger_timed[CHART_HANDLER_CHANNEL_COUNT];
+    int64_t trigger_start[CHART_HANDLER_CHANNEL_COUNT];
+
+    // The hysteresis is armed when the signal moves past the band on the opposite side of the edge,
+    // a pending event was found after the last value of the previous block, the frame is displayed
+    // without an event because the auto mode timeout expired
+    ChartHandlerTriggerState trigger_state[CHART_HANDLER_CHANNEL_COUNT];
+    bool trigger_armed[CHART_HANDLER_CHANNEL_COUNT];
+    bool trigger_pending[CHART_HANDLER_CHANNEL_COUNT];
+    bool trigger_forced[CHART_HANDLER_CHANNEL_COUNT];
+    float trigger_wait[CHART_HANDLER_CHANNEL_COUNT]; // in us
+    float trigger_holdoff_left[CHART_HANDLER_CHANNEL_COUNT]; // in us, from the start of the next block
+
+    // Position of the last crossing in samples from the start of the current block
+    // and distance between the crossing and the trigger value in values (between 0 and 1)
+    float trigger_crossing[CHART_HANDLER_CHANNEL_COUNT];
+    float trigger_fraction[CHART_HANDLER_CHANNEL_COUNT];
+
+    // Index of the raw value that crossed the trigger and delay of its frame in values
     int32_t trigger_index[CHART_HANDLER_CHANNEL_COUNT];
+    size_t trigger_delay_count[CHART_HANDLER_CHANNEL_COUNT];
 
     // Number of values before and after the trigger
     size_t trigger_before_count[CHART_HANDLER_CHANNEL_COUNT];
     size_t trigger_after_count[CHART_HANDLER_CHANNEL_COUNT];
+
+    // Index inside the record of the last value taken before the channel stopped
+    int32_t record_index[CHART_HANDLER_CHANNEL_COUNT];
+
+    // Time of the last trigger event since the acquisition was initialized
+    double trigger_time[CHART_HANDLER_CHANNEL_COUNT]; // in us
+
+    // Displayed segment (or CHART_HANDLER_SEGMENT_OVERLAY) and segments to draw again
+    size_t segment_view;
+    bool segment_update[CHART_HANDLER_CHANNEL_COUNT];
+
+    // Equivalent-time sampling, values filled by the acquisitions merged so far
+    bool equivalent_time;
+    bool filled[CHART_HANDLER_CHANNEL_COUNT][CHART_HANDLER_VALUES_COUNT];
+    size_t filled_count[CHART_HANDLER_CHANNEL_COUNT];
+    size_t acquisition_count[CHART_HANDLER_CHANNEL_COUNT];
  
+    // Acquisition mode, minimum, maximum and sum of the samples taken since the last value
+    ChartHandlerAcquisitionMode acquisition_mode;
+    uint16_t peak_min[CHART_HANDLER_CHANNEL_COUNT];
+    uint16_t peak_max[CHART_HANDLER_CHANNEL_COUNT];
+    uint64_t high_resolution_sum[CHART_HANDLER_CHANNEL_COUNT];
+    size_t high_resolution_count[CHART_HANDLER_CHANNEL_COUNT];
+
+    // Base 2 logarithm of the number of averaged frames and frames averaged so far
+    uint32_t average_shift;
+    size_t average_frames[CHART_HANDLER_CHANNEL_COUNT];
+
     // Knobs
     ChartHandlerKnobMode knob_mode;
 
@@ -98,7 +328,11 @@ typedef struct {
     bool ready[CHART_HANDLER_CHANNEL_COUNT];
     size_t index[CHART_HANDLER_CHANNEL_COUNT];
     uint16_t raw[CHART_HANDLER_CHANNEL_COUNT][CHART_HANDLER_VALUES_COUNT];
-    float data[CHART_HANDLER_CHANNEL_COUNT][CHART_HANDLER_VALUES_COUNT];
+    uint16_t raw_min[CHART_HANDLER_CHANNEL_COUNT][CHART_HANDLER_VALUES_COUNT];
+    uint16_t raw_max[CHART_HANDLER_CHANNEL_COUNT][CHART_HANDLER_VALUES_COUNT];
+    int32_t average[CHART_HANDLER_CHANNEL_COUNT][CHART_HANDLER_VALUES_COUNT];
+    int16_t data[CHART_HANDLER_CHANNEL_COUNT][CHART_HANDLER_VALUES_COUNT];
+    int16_t data_min[CHART_HANDLER_CHANNEL_COUNT][CHART_HANDLER_VALUES_COUNT];
 } ChartHandler;
 
 /**
@@ -210,6 +444,289 @@ void chart_handler_toggle_running(ChartHandler * handler, ChartHandlerChannel ch
  */
 bool chart_handler_is_trigger_enabled(ChartHandler * handler);
 
+/**
+ * @brief Check if the equivalent-time sampling is enabled
+ *
+ * @param handler A pointer to the chart handler structure
+ *
+ * @return bool True if the equivalent-time sampling is enabled, false otherwise
+ */
+bool chart_handler_is_equivalent_time_enabled(ChartHandler * handler);
+
+/**
+ * @brief Enable or disable the equivalent-time sampling
+ *
+ * @details When enabled the time scale can go down to CHART_EQUIVALENT_TIME_MIN_X_SCALE,
+ * if the ADC is too slow for the time scale the samples around many trigger crossings
+ * of a repetitive signal are merged into a single frame using the position of each crossing
+ * between two samples
+ * @attention The equivalent-time sampling is used only if the trigger is enabled
+ *
+ * @param handler A pointer to the chart handler structure
+ * @param enabled True to enable, false to disable
+ */
+void chart_handler_set_equivalent_time(ChartHandler * handler, bool enabled);
+
+/**
+ * @brief Get the way the samples are reduced to the displayed values
+ *
+ * @param handler A pointer to the chart handler structure
+ *
+ * @return ChartHandlerAcquisitionMode The acquisition mode
+ */
+ChartHandlerAcquisitionMode chart_handler_get_acquisition_mode(ChartHandler * handler);
+
+/**
+ * @brief Set the way the samples are reduced to the displayed values
+ *
+ * @param handler A pointer to the chart handler structure
+ * @param mode The acquisition mode to set
+ */
+void chart_handler_set_acquisition_mode(ChartHandler * handler, ChartHandlerAcquisitionMode mode);
+
+/**
+ * @brief Get the number of frames averaged in average mode
+ *
+ * @param handler A pointer to the chart handler structure
+ *
+ * @return size_t The number of averaged frames
+ */
+size_t chart_handler_get_average_count(ChartHandler * handler);
+
+/**
+ * @brief Set the number of frames averaged in average mode
+ *
+ * @details The average restarts from the next frame
+ *
+ * @param handler A pointer to the chart handler structure
+ * @param count The number of frames, a power of 2 between CHART_HANDLER_AVERAGE_MIN_COUNT
+ * and CHART_HANDLER_AVERAGE_MAX_COUNT
+ */
+void chart_handler_set_average_count(ChartHandler * handler, size_t count);
+
+/**
+ * @brief Get the way the trigger starts a new frame
+ *
+ * @param handler A pointer to the chart handler structure
+ *
+ * @return ChartHandlerTriggerMode The trigger mode
+ */
+ChartHandlerTriggerMode chart_handler_get_trigger_mode(ChartHandler * handler);
+
+/**
+ * @brief Set the way the trigger starts a new frame
+ *
+ * @details The values taken so far are discarded
+ *
+ * @param handler A pointer to the chart handler structure
+ * @param mode The trigger mode to set
+ */
+void chart_handler_set_trigger_mode(ChartHandler * handler, ChartHandlerTriggerMode mode);
+
+/**
+ * @brief Get the signal searched for the trigger events
+ *
+ * @param handler A pointer to the chart handler structure
+ *
+ * @return ChartHandlerTriggerSource The trigger source
+ */
+ChartHandlerTriggerSource chart_handler_get_trigger_source(ChartHandler * handler);
+
+/**
+ * @brief Set the signal searched for the trigger events
+ *
+ * @details The values taken so far are discarded
+ *
+ * @param handler A pointer to the chart handler structure
+ * @param source The trigger source to set
+ */
+void chart_handler_set_trigger_source(ChartHandler * handler, ChartHandlerTriggerSource source);
+
+/**
+ * @brief Get the channel whose samples are searched for the trigger events
+ *
+ * @param handler A pointer to the chart handler structure
+ *
+ * @return ChartHandlerChannel The source channel, CHART_HANDLER_CHANNEL_COUNT if the
+ * source is not a channel
+ */
+ChartHandlerChannel chart_handler_get_trigger_channel(ChartHandler * handler);
+
+/**
+ * @brief Get the minimum time between two trigger events
+ *
+ * @param handler A pointer to the chart handler structure
+ *
+ * @return float The holdoff time in us
+ */
+float chart_handler_get_trigger_holdoff(ChartHandler * handler);
+
+/**
+ * @brief Set the minimum time between two trigger events
+ *
+ * @details The events found before the holdoff time is elapsed since the previous one are ignored,
+ * which keeps complex signals like bursts stable on the chart
+ *
+ * @param handler A pointer to the chart handler structure
+ * @param holdoff The holdoff time in us, 0 to disable it
+ */
+void chart_handler_set_trigger_holdoff(ChartHandler * handler, float holdoff);
+
+/**
+ * @brief Get the hysteresis of the trigger
+ *
+ * @param handler A pointer to the chart handler structure
+ *
+ * @return uint16_t The hysteresis in raw ADC units
+ */
+uint16_t chart_handler_get_trigger_hysteresis(ChartHandler * handler);
+
+/**
+ * @brief Set the hysteresis of the trigger
+ *
+ * @details After an event the signal has to move past the trigger level minus the hysteresis
+ * (plus for the falling edge) before a new event is accepted, so the noise around the level
+ * cannot trigger the channel many times
+ *
+ * @param handler A pointer to the chart handler structure
+ * @param hysteresis The hysteresis in raw ADC units
+ */
+void chart_handler_set_trigger_hysteresis(ChartHandler * handler, uint16_t hysteresis);
+
+/**
+ * @brief Get the position of the trigger on the chart
+ *
+ * @param handler A pointer to the chart handler structure
+ *
+ * @return float The position in % of the chart width from the left edge
+ */
+float chart_handler_get_trigger_position(ChartHandler * handler);
+
+/**
+ * @brief Set the position of the trigger on the chart
+ *
+ * @details The position splits the displayed values between the ones taken before and after
+ * the trigger, the values taken so far are discarded
+ *
+ * @param handler A pointer to the chart handler structure
+ * @param position The position in % of the chart width from the left edge (between 0 and 100)
+ */
+void chart_handler_set_trigger_position(ChartHandler * handler, float position);
+
+/**
+ * @brief Get the delay between the trigger and the displayed values
+ *
+ * @param handler A pointer to the chart handler structure
+ *
+ * @return float The delay in us
+ */
+float chart_handler_get_trigger_delay(ChartHandler * handler);
+
+/**
+ * @brief Set the delay between the trigger and the displayed values
+ *
+ * @details The displayed values are moved to the right of the trigger by the delay, which can be
+ * many times the width of the chart, the values taken so far are discarded
+ *
+ * @param handler A pointer to the chart handler structure
+ * @param delay The delay in us, 0 to disable it
+ */
+void chart_handler_set_trigger_delay(ChartHandler * handler, float delay);
+
+/**
+ * @brief Get the kind of event searched by the trigger
+ *
+ * @param handler A pointer to the chart handler structure
+ *
+ * @return ChartHandlerTriggerType The trigger type
+ */
+ChartHandlerTriggerType chart_handler_get_trigger_type(ChartHandler * handler);
+
+/**
+ * @brief Set the kind of event searched by the trigger
+ *
+ * @details The values taken so far are discarded
+ *
+ * @param handler A pointer to the chart handler structure
+ * @param type The trigger type to set
+ */
+void chart_handler_set_trigger_type(ChartHandler * handler, ChartHandlerTriggerType type);
+
+/**
+ * @brief Get the time condition of the pulse width and slope triggers
+ *
+ * @param handler A pointer to the chart handler structure
+ *
+ * @return ChartHandlerTriggerCondition The time condition
+ */
+ChartHandlerTriggerCondition chart_handler_get_trigger_condition(ChartHandler * handler);
+
+/**
+ * @brief Set the time condition of the pulse width and slope triggers
+ *
+ * @param handler A pointer to the chart handler structure
+ * @param condition The time condition to set
+ */
+void chart_handler_set_trigger_condition(ChartHandler * handler, ChartHandlerTriggerCondition condition);
+
+/**
+ * @brief Set the time limits of the pulse width, glitch and slope triggers
+ *
+ * @details The limits are expressed in divisions so that they follow the time scale
+ *
+ * @param handler A pointer to the chart handler structure
+ * @param low The lower limit in divisions
+ * @param high The upper limit in divisions, only used by the range condition
+ */
+void chart_handler_set_trigger_limits(ChartHandler * handler, float low, float high);
+
+/**
+ * @brief Get the second level of the runt and slope triggers of a single channel
+ *
+ * @param handler A pointer to the chart handler structure
+ * @param ch The channel to get the level from
+ *
+ * @return uint16_t The second level in raw ADC units
+ */
+uint16_t chart_handler_get_trigger_second(ChartHandler * handler, ChartHandlerChannel ch);
+
+/**
+ * @brief Set the second level of the runt and slope triggers of a single channel
+ *
+ * @details The runt pulses and the slopes go from the trigger level towards the second
+ * level, which is above the trigger level for the ascending polarity and below it for
+ * the descending one
+ * @attention No runt or slope event is found while the second level is on the wrong side
+ * of the trigger level, which can happen if the trigger level or the polarity change
+ *
+ * @param handler A pointer to the chart handler structure
+ * @param ch The channel to set the level to
+ * @param value The second level in raw ADC units
+ *
+ * @return HAL_StatusTypeDef HAL_ERROR if the level is on the wrong side of the trigger level
+ */
+HAL_StatusTypeDef chart_handler_set_trigger_second(ChartHandler * handler, ChartHandlerChannel ch, uint16_t value);
+
+/**
+ * @brief Get the segment displayed while the channels are stopped in segmented mode
+ *
+ * @param handler A pointer to the chart handler structure
+ *
+ * @return size_t The index of the segment, CHART_HANDLER_SEGMENT_OVERLAY if every segment is displayed
+ */
+size_t chart_handler_get_segment_view(ChartHandler * handler);
+
+/**
+ * @brief Set the segment displayed while the channels are stopped in segmented mode
+ *
+ * @details With CHART_HANDLER_SEGMENT_OVERLAY every segment is drawn into the persistence
+ * buffers, so the persistence must be enabled to see them over each other
+ *
+ * @param handler A pointer to the chart handler structure
+ * @param view The index of the segment or CHART_HANDLER_SEGMENT_OVERLAY
+ */
+void chart_handler_set_segment_view(ChartHandler * handler, size_t view);
+
 /**
  * @brief Get the current offset of a single channel
  *
@@ -287,6 +804,18 @@ float chart_handler_get_x_offset(ChartHandler * handler, ChartHandlerChannel ch)
  */
 void chart_handler_set_x_offset(ChartHandler * handler, ChartHandlerChannel ch, float value);
 
+/**
+ * @brief Get the timebase used to choose the sample rate of the ADC
+ *
+ * @details The channels share the same ADC sample rate so the smallest time scale
+ * of the enabled channels is used
+ *
+ * @param handler A pointer to the chart handler structure
+ *
+ * @return float The time scale per division in us
+ */
+float chart_handler_get_timebase(ChartHandler * handler);
+
 /**
  * @brief Convert a voltage in millivot to grid units (i.e. the divisions of the grid)
  *
@@ -301,10 +830,12 @@ float chart_handler_voltage_to_grid_units(ChartHandler * handler, ChartHandlerCh
 /**
  * @brief Update the chart handler values
  *
+ * @details Consecutive blocks are treated as a continuous stream of samples
+ *
  * @param handler A pointer to the chart handler structure
- * @param t The amount of time taken by the ADC to make the sampling and conversion in us
+ * @param block A pointer to the block of raw samples to process
  */
-void chart_handler_update(ChartHandler * handler, uint32_t t);
+void chart_handler_update(ChartHandler * handler, const ChartHandlerBlock * block);
 
 /**
  * @brief Chart handler routine that updates all the values
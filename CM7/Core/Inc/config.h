@@ -28,8 +28,12 @@
 #define LED_RED_Pin LED3_Pin
 #define LED_BLUE_Pin LED4_Pin
 
-/** @brief ADC reolution in bits */
-#define ADC_RESOLUTION (14U)
+/** @brief The external trigger input (every free EXTI line is already taken by the board) */
+#define EXTERNAL_TRIGGER_GPIO_Port JOY_SELECT_GPIO_Port
+#define EXTERNAL_TRIGGER_Pin JOY_SELECT_Pin
+
+/** @brief ADC reolution in bits (the acquisition profiles always output 16 bit samples) */
+#define ADC_RESOLUTION (16U)
 /** @brief ADC voltage reference in mV */
 #define ADC_VREF (3300.0f)
 
@@ -51,9 +55,35 @@
  */
 #define ADC_VOLTAGE_TO_VALUE(VAL) ((uint16_t)(((VAL) / (ADC_VREF)) * ((float)((1U << ADC_RESOLUTION) - 1.0f))))
 
+/*** MEMORY ***/
+
+/**
+ * @brief Place a variable in the AXI SRAM section used for the DMA buffers
+ *
+ * @details The DTCM RAM where the other variables are placed cannot be reached by the DMA
+ * The variable is aligned to the cache line size so that its cache maintenance
+ * does not affect the nearby variables
+ */
+#define DMA_BUFFER __attribute__((section(".dma_buffer"), aligned(__SCB_DCACHE_LINE_SIZE)))
+
+/**
+ * @brief Place a large variable in the AXI SRAM
+ *
+ * @details Used for the tables that do not fit inside the DTCM RAM together with the other variables
+ */
+#define AXI_RAM __attribute__((section(".axi_ram")))
+
+/** @brief AXI SRAM size */
+#define AXI_SRAM_SIZE (512U * 1024U)
+
+/** @brief SDRAM info, the whole SDRAM is not cacheable (see MPU_Config) */
+#define SDRAM_ADDRESS (0xD0000000)
+#define SDRAM_SIZE (32U * 1024U * 1024U)
+
 /*** LCD ***/
 
 /** @brief The LCD color depth in bytes */
+#define LCD_COLOR_DEPTH_L8 sizeof(uint8_t)
 #define LCD_COLOR_DEPTH_RGB565 sizeof(uint16_t)
 #define LCD_COLOR_DEPTH_ARGB8888 sizeof(uint32_t)
 
@@ -65,7 +95,7 @@
 #define LCD_BYTE_COUNT (LCD_RESOLUTION * LCD_COLOR_DEPTH)
 
 /** @brief LCD frame buffer info */
-#define LCD_FRAME_BUFFER_0_ADDRESS (0xD0000000)
+#define LCD_FRAME_BUFFER_0_ADDRESS (SDRAM_ADDRESS)
 #define LCD_FRAME_BUFFER_0_WIDTH LCD_BYTE_COUNT
 
 #define LCD_FRAME_BUFFER_1_ADDRESS (LCD_FRAME_BUFFER_0_ADDRESS + LCD_FRAME_BUFFER_0_WIDTH)
@@ -75,17 +105,66 @@
 
 /*** CHART ***/
 
-/** @brief Chart ADC data memory address */
-#define CHART_RAW_DATA_BASE_ADDRESS (LCD_FRAME_BUFFER_1_ADDRESS + LCD_FRAME_BUFFER_1_WIDTH)
+/**
+ * @brief Chart ADC data size of each channel
+ *
+ * @details The channels are converted simultaneously by two ADCs and the DMA
+ * copies both samples at once, so the samples of each channel are interleaved
+ * The buffer is placed in the internal SRAM (see DMA_BUFFER)
+ */
 #define CHART_RAW_DATA_WIDTH (CHART_SAMPLE_COUNT * sizeof(uint16_t))
 
-#define CHART_CH1_RAW_DATA_ADDRESS CHART_RAW_DATA_BASE_ADDRESS
-#define CHART_CH1_RAW_DATA_WIDTH CHART_RAW_DATA_WIDTH
+/** @brief Distance between two consecutive samples of the same channel */
+#define CHART_RAW_DATA_STRIDE (2U)
 
-#define CHART_CH2_RAW_DATA_ADDRESS (CHART_CH1_RAW_DATA_ADDRESS + CHART_CH1_RAW_DATA_WIDTH)
-#define CHART_CH2_RAW_DATA_WIDTH CHART_RAW_DATA_WIDTH
+#define CHART_TOTAL_RAW_DATA_WIDTH (CHART_RAW_DATA_STRIDE * CHART_RAW_DATA_WIDTH)
 
-#define CHART_TOTAL_RAW_DATA_WIDTH (CHART_CH1_RAW_DATA_WIDTH + CHART_CH2_RAW_DATA_WIDTH)
+/**
+ * @brief Deep memory record info
+ *
+ * @details The record is placed in the SDRAM after the frame buffers and keeps
+ * the samples of both channels interleaved like the raw data
+ */
+#define CHART_RECORD_ADDRESS (LCD_FRAME_BUFFER_1_ADDRESS + LCD_FRAME_BUFFER_1_WIDTH)
+#define CHART_RECORD_WIDTH (CHART_RECORD_MAX_SAMPLE_COUNT * CHART_RAW_DATA_STRIDE * sizeof(uint16_t))
+
+/** @brief Minimum, maximum and default number of samples of each channel kept in the record */
+#define CHART_RECORD_MIN_SAMPLE_COUNT (CHART_SAMPLE_COUNT)
+#define CHART_RECORD_MAX_SAMPLE_COUNT (4U * 1024U * 1024U)
+#define CHART_RECORD_DEFAULT_SAMPLE_COUNT (1024U * 1024U)
+
+/**
+ * @brief Persistence intensity buffers info
+ *
+ * @details The buffers are placed in the SDRAM after the record, each channel has
+ * a buffer with one byte of intensity for each pixel of the chart
+ */
+#define CHART_PERSISTENCE_ADDRESS (CHART_RECORD_ADDRESS + CHART_RECORD_WIDTH)
+#define CHART_PERSISTENCE_CHANNEL_WIDTH (LCD_WIDTH * CHART_HEIGHT)
+#define CHART_PERSISTENCE_WIDTH (2U * CHART_PERSISTENCE_CHANNEL_WIDTH)
+
+/**
+ * @brief Waveform frame buffer info
+ *
+ * @details The frame buffer of the LTDC foreground layer is placed in the SDRAM after
+ * the persistence buffers, it has an L8 pixel (palette index) for each pixel of the chart
+ */
+#define CHART_WAVEFORM_ADDRESS (CHART_PERSISTENCE_ADDRESS + CHART_PERSISTENCE_WIDTH)
+#define CHART_WAVEFORM_PIXEL_COUNT (LCD_WIDTH * CHART_HEIGHT)
+#define CHART_WAVEFORM_WIDTH (CHART_WAVEFORM_PIXEL_COUNT * LCD_COLOR_DEPTH_L8)
+
+/** @brief LTDC layers of the user interface (background) and of the waveforms (foreground) */
+#define LCD_BACKGROUND_LAYER (0U)
+#define LCD_WAVEFORM_LAYER (1U)
+
+/**
+ * @brief Segmented memory info
+ *
+ * @details The segments are placed in the SDRAM after the waveform buffers,
+ * each channel has room for the maximum number of segments
+ */
+#define CHART_SEGMENTS_ADDRESS (CHART_WAVEFORM_ADDRESS + CHART_WAVEFORM_WIDTH)
+#define CHART_SEGMENTS_MAX_COUNT (1000U)
 
 /** @brief Primary and secondary Y axis maximum coordinates for the chart */
 #define CHART_AXIS_PRIMARY_Y_MAX_COORD (500U)
@@ -99,12 +178,10 @@
 #define CHART_X_DIVISION_COUNT (CHART_VERTICAL_LINE_COUNT - 1U)
 #define CHART_Y_DIVISION_COUNT (CHART_HORIZONTAL_LINE_COUNT - 1U)
 
-/** @brief Total number of points of the chart */
-#define CHART_POINT_COUNT ((CHART_X_DIVISION_COUNT) * 100U)
-
 /** @brief Minimum and maximum values per division for the X value of the chart in us */
 #define CHART_MIN_X_SCALE (100.0f) // in us
 #define CHART_MAX_X_SCALE (300000.0f) // in us
+#define CHART_EQUIVALENT_TIME_MIN_X_SCALE (1.0f) // in us
 #define CHART_DEFAULT_X_SCALE (10000.0f) // in mV
 
 /** @brief Minimum and maximum values per division for the Y value of the chart in mV */
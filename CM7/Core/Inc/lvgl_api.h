@@ -37,7 +37,8 @@ typedef struct {
 
     // Chart
     lv_obj_t * chart;
-    lv_chart_series_t * series[CHART_HANDLER_CHANNEL_COUNT];
+    lv_color_t colors[CHART_HANDLER_CHANNEL_COUNT];
+    bool waveform_layer_enabled;
 
     // Trigger
     lv_point_precise_t trigger_points[CHART_HANDLER_CHANNEL_COUNT][2];
@@ -45,17 +46,40 @@ typedef struct {
     bool trigger_update[CHART_HANDLER_CHANNEL_COUNT];
     lv_obj_t * trigger_checkbox_asc;
     lv_obj_t * trigger_checkbox_desc;
+    lv_obj_t * trigger_checkbox_watchdog;
+    lv_obj_t * trigger_mode_dropdown;
+    lv_obj_t * trigger_source_dropdown;
+    lv_obj_t * holdoff_dropdown;
+    lv_obj_t * trigger_position_dropdown;
+    lv_obj_t * trigger_delay_dropdown;
+    lv_obj_t * trigger_hysteresis_dropdown;
+    lv_obj_t * trigger_type_dropdown;
+    lv_obj_t * trigger_condition_dropdown;
+    lv_obj_t * trigger_limit_low_dropdown;
+    lv_obj_t * trigger_limit_high_dropdown;
+    lv_obj_t * trigger_second_dropdown;
+    lv_obj_t * equivalent_time_checkbox;
     
     // Settings
     lv_obj_t * knob_switch;
     lv_obj_t * knob_label;
+    lv_obj_t * record_dropdown;
+    lv_obj_t * acquisition_dropdown;
+    lv_obj_t * average_dropdown;
+    lv_obj_t * pacing_dropdown;
+    lv_obj_t * persistence_dropdown;
+
+    // Segments
+    lv_obj_t * segments_dropdown;
+    lv_obj_t * segment_overlay_checkbox;
+    lv_obj_t * segment_label;
+    bool segment_update;
 
     // Loading bar
     lv_obj_t * loading_bar;
     size_t loading_bar_value;
     bool loading_bar_hide;
 
-    int32_t channels[CHART_HANDLER_CHANNEL_COUNT][CHART_POINT_COUNT];
     ChartHandler chart_handler;
 } LvHandler;
 
@@ -108,6 +132,13 @@ float lv_api_grid_units_to_screen(ChartHandlerChannel ch, float value);
  */
 void lv_api_update_div_text(LvHandler * handler);
 
+/**
+ * @brief Update the text that display the selected segment and its timestamp
+ *
+ * @param handler A ponter to the LVGL handler structure
+ */
+void lv_api_update_segment_text(LvHandler * handler);
+
 /**
  * @brief Update the current status of the touch screen
  * @attention This function does not work with more than one touch screen device
@@ -180,18 +211,22 @@ void lv_api_clear_channel_data(LvHandler * handler, ChartHandlerChannel ch);
  *
  * @param handler A pointer to the LVGL handler structure
  * @param ch The channel to update the point to
- * @param values The array of new values in grid units
+ * @param values The array of new values in chart coordinates, CHART_HANDLER_POINT_NONE
+ * for the values which are not displayed
+ * @param min_values The array of minimum values in chart coordinates, if not NULL each value
+ * is drawn as a vertical span from the minimum to the value
  * @param size The lenght of the array
  */
 void lv_api_update_points(
     LvHandler * handler,
     ChartHandlerChannel ch,
-    float * values,
+    const int16_t * values,
+    const int16_t * min_values,
     size_t size
 );
 
 /**
- * @brief Update all the point of the chart on the display
+ * @brief Redraw the chart on the display
  *
  * @param handler The LVGL handler structure
  */
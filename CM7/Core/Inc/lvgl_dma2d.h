@@ -0,0 +1,28 @@
+/**
+ * @file lvgl_dma2d.h
+ * @brief LVGL draw unit which uses the DMA2D for the fills and the images
+ *
+ * @details The plain rectangle fills, the image blits and the alpha blending of
+ * the images are done by the DMA2D directly inside the frame buffers, every other
+ * draw task is left to the software renderer
+ *
+ * @date Oct 16, 2026
+ * @author Antonio Gelain [antonio.gelain@studenti.unitn.it]
+ */
+
+#ifndef LVGL_DMA2D_H
+#define LVGL_DMA2D_H
+
+#include "main.h"
+
+#include "lvgl.h"
+
+/**
+ * @brief Create the DMA2D draw unit and register it inside LVGL
+ * @attention This function should be called after lv_init and after the DMA2D is initialized
+ *
+ * @param hdma2d A pointer to the DMA2D handler structure
+ */
+void lv_dma2d_init(DMA2D_HandleTypeDef * hdma2d);
+
+#endif  // LVGL_DMA2D_H
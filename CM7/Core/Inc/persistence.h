@@ -0,0 +1,156 @@
+/**
+ * @file persistence.h
+ * @brief Persistence of the displayed waveforms
+ *
+ * @details Every displayed waveform is drawn into an intensity buffer as large as
+ * the chart which fades over time, so that the intermittent events stay visible
+ * after the chart is updated with the following waveforms
+ *
+ * @date Oct 16, 2026
+ * @author Antonio Gelain [antonio.gelain@studenti.unitn.it]
+ */
+
+#ifndef PERSISTENCE_H
+#define PERSISTENCE_H
+
+#include "main.h"
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+#include "chart_handler.h"
+
+/** @brief Decay time used to keep the waveforms forever */
+#define PERSISTENCE_INFINITE (UINT32_MAX)
+
+/** @brief Intensity of a pixel when a waveform is drawn over it */
+#define PERSISTENCE_MAX_INTENSITY (UINT8_MAX)
+
+/** @brief Minimum intensity faded at once, so that the buffers are not updated for changes too small to be displayed */
+#define PERSISTENCE_MIN_FADE (4U)
+
+/** @brief Row used for the columns without any row */
+#define PERSISTENCE_NO_ROW (-1)
+
+/**
+ * @brief Initialize the persistence as disabled and clear the intensity buffers
+ * @attention The SDRAM must be initialized before calling this function
+ */
+void persistence_init(void);
+
+/**
+ * @brief Set the size of the area where the waveforms are drawn
+ *
+ * @details The intensity buffers are cleared
+ *
+ * @param width The width of the area in pixels
+ * @param height The height of the area in pixels
+ *
+ * @return HAL_StatusTypeDef HAL_OK if the area fits inside the buffers
+ */
+HAL_StatusTypeDef persistence_set_size(size_t width, size_t height);
+
+/**
+ * @brief Get the intensity buffer of a single channel
+ *
+ * @details The buffer has a byte for each pixel stored row by row
+ *
+ * @param ch The channel to select
+ *
+ * @return uint8_t * A pointer to the intensity buffer
+ */
+uint8_t * persistence_get_buffer(ChartHandlerChannel ch);
+
+/**
+ * @brief Check if the persistence is enabled
+ *
+ * @return bool True if the persistence is enabled, false otherwise
+ */
+bool persistence_is_enabled(void);
+
+/**
+ * @brief Get the time taken by a waveform to fade completely
+ *
+ * @return uint32_t The decay time in ms, 0 if the persistence is disabled
+ */
+uint32_t persistence_get_decay_time(void);
+
+/**
+ * @brief Set the time taken by a waveform to fade completely
+ *
+ * @details The intensity buffers are cleared
+ *
+ * @param decay_time The decay time in ms, 0 to disable the persistence or
+ * PERSISTENCE_INFINITE to keep the waveforms forever
+ */
+void persistence_set_decay_time(uint32_t decay_time);
+
+/**
+ * @brief Clear the intensity buffer of a single channel
+ *
+ * @details The cleared rows are marked as changed
+ *
+ * @param ch The channel to clear
+ */
+void persistence_clear(ChartHandlerChannel ch);
+
+/**
+ * @brief Draw a waveform into the intensity buffer of a single channel
+ *
+ * @details The waveform is given as the vertical span drawn on each column
+ * The drawn rows are not marked as changed since the waveform is displayed over them
+ *
+ * @param ch The channel to draw
+ * @param top The first row of the span of each column, negative for the empty columns
+ * @param bottom The last row of the span of each column
+ * @param count The number of columns
+ */
+void persistence_draw(ChartHandlerChannel ch, const int16_t * top, const int16_t * bottom, size_t count);
+
+/**
+ * @brief Fade the intensity buffers based on the time elapsed since the last call
+ * @attention This function should be called once for every displayed frame
+ *
+ * @details Only the union of the rows drawn since each column faded out is updated, a word at a time,
+ * and the rows of each column are marked as changed
+ *
+ * @return bool True if the intensities changed, false otherwise
+ */
+bool persistence_decay(void);
+
+/**
+ * @brief Check if some intensities changed since the last reset of the changes
+ *
+ * @return bool True if some rows are changed, false otherwise
+ */
+bool persistence_is_changed(void);
+
+/**
+ * @brief Get the first changed row of each column
+ *
+ * @return const int16_t * A pointer to the rows, PERSISTENCE_NO_ROW for the unchanged columns
+ */
+const int16_t * persistence_get_changed_top(void);
+
+/**
+ * @brief Get the last changed row of each column
+ *
+ * @return const int16_t * A pointer to the rows, PERSISTENCE_NO_ROW for the unchanged columns
+ */
+const int16_t * persistence_get_changed_bottom(void);
+
+/**
+ * @brief Get the union of the changed rows of every column
+ *
+ * @param first The first changed row, PERSISTENCE_NO_ROW if nothing changed
+ * @param last The last changed row, PERSISTENCE_NO_ROW if nothing changed
+ */
+void persistence_get_changed_rows(int16_t * first, int16_t * last);
+
+/**
+ * @brief Forget the changed rows once they are displayed
+ */
+void persistence_reset_changes(void);
+
+#endif  // PERSISTENCE_H
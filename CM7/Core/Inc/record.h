@@ -0,0 +1,118 @@
+/**
+ * @file record.h
+ * @brief Deep memory record of the acquired samples
+ *
+ * @details Every acquired block is copied into a circular buffer placed in the SDRAM
+ * which keeps the last samples of both channels at full rate, so that the signal
+ * can still be zoomed and scrolled after the channels are stopped
+ *
+ * @date Oct 16, 2026
+ * @author Antonio Gelain [antonio.gelain@studenti.unitn.it]
+ */
+
+#ifndef RECORD_H
+#define RECORD_H
+
+#include "main.h"
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+#include "chart_handler.h"
+
+/** @brief Maximum number of blocks needed to describe a window of the record (it can wrap around once) */
+#define RECORD_WINDOW_BLOCK_COUNT (2U)
+
+/**
+ * @brief Initialize the record with the default length
+ * @attention The SDRAM must be initialized before any sample is recorded
+ */
+void record_init(void);
+
+/**
+ * @brief Get the maximum number of samples of each channel kept in the record
+ *
+ * @return size_t The record length in samples, 0 if the record is disabled
+ */
+size_t record_get_length(void);
+
+/**
+ * @brief Set the maximum number of samples of each channel kept in the record
+ *
+ * @details The recorded samples are discarded, the blocks are not written while
+ * the length is changed so it is safe to call during the acquisition
+ *
+ * @param length The record length in samples, 0 to disable the record
+ *
+ * @return HAL_StatusTypeDef HAL_OK if the length is valid
+ */
+HAL_StatusTypeDef record_set_length(size_t length);
+
+/**
+ * @brief Discard the recorded samples
+ *
+ * @details It should be called every time the sample period changes since all
+ * the samples inside the record must be equally spaced
+ * @attention The samples are kept while the record is frozen
+ */
+void record_reset(void);
+
+/**
+ * @brief Check if the record is frozen
+ *
+ * @return bool True if the new blocks are ignored, false otherwise
+ */
+bool record_is_frozen(void);
+
+/**
+ * @brief Freeze or unfreeze the record
+ *
+ * @details While frozen the new blocks are ignored so the recorded samples can be read,
+ * unfreezing the record discards its samples since the acquisition went on in the meantime
+ *
+ * @param frozen True to freeze the record, false to unfreeze it
+ */
+void record_set_frozen(bool frozen);
+
+/**
+ * @brief Get the number of samples of each channel currently inside the record
+ *
+ * @return size_t The number of samples
+ */
+size_t record_get_count(void);
+
+/**
+ * @brief Get the time between two consecutive samples of the record
+ *
+ * @return float The sample period in us
+ */
+float record_get_time_per_sample(void);
+
+/**
+ * @brief Append a block of samples to the record
+ * @attention This function should be called for every acquired block, before
+ * it is processed by the chart handler
+ *
+ * @details The oldest samples are overwritten when the record is full
+ *
+ * @param block A pointer to the block of samples to append
+ */
+void record_write(const ChartHandlerBlock * block);
+
+/**
+ * @brief Get a window of the record without copying its samples
+ *
+ * @details The window is clamped to the recorded samples and, since the record is
+ * circular, it is split in two blocks when it wraps around the end of the buffer
+ * @attention The content of the blocks is valid only while the record is frozen
+ *
+ * @param start The index of the first sample of the window (0 is the oldest recorded sample)
+ * @param count The number of samples of the window
+ * @param blocks The blocks that describe the window (at least RECORD_WINDOW_BLOCK_COUNT)
+ *
+ * @return size_t The number of blocks used for the window, 0 if the window is empty
+ */
+size_t record_get_window(size_t start, size_t count, ChartHandlerBlock * blocks);
+
+#endif  // RECORD_H
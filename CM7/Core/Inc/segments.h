@@ -0,0 +1,118 @@
+/**
+ * @file segments.h
+ * @brief Segmented memory of the triggered frames
+ *
+ * @details In segmented mode every triggered frame is saved into its own segment of
+ * the SDRAM as soon as it is complete and the trigger is armed again right away, so
+ * bursts of events close together are captured without waiting for the display
+ * The channels are stopped once every segment is filled
+ *
+ * @date Oct 16, 2026
+ * @author Antonio Gelain [antonio.gelain@studenti.unitn.it]
+ */
+
+#ifndef SEGMENTS_H
+#define SEGMENTS_H
+
+#include "main.h"
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+#include "chart_handler.h"
+
+/**
+ * @brief Type definition for a single segment of a channel
+ *
+ * @details The values are stored in display order with the trigger crossing already
+ * aligned on the trigger position
+ *
+ * @param timestamp The time of the trigger event in us since the acquisition was initialized
+ * @param raw The values of the frame
+ * @param raw_min The minimum of the samples of each value in peak detect mode
+ * @param raw_max The maximum of the samples of each value in peak detect mode
+ */
+typedef struct {
+    double timestamp; // in us
+    uint16_t raw[CHART_HANDLER_VALUES_COUNT];
+    uint16_t raw_min[CHART_HANDLER_VALUES_COUNT];
+    uint16_t raw_max[CHART_HANDLER_VALUES_COUNT];
+} Segment;
+
+/**
+ * @brief Initialize the segmented memory as disabled
+ * @attention The SDRAM must be initialized before any segment is saved
+ */
+void segments_init(void);
+
+/**
+ * @brief Get the number of segments of each channel captured before stopping
+ *
+ * @return size_t The number of segments, 0 if the segmented mode is disabled
+ */
+size_t segments_get_length(void);
+
+/**
+ * @brief Set the number of segments of each channel captured before stopping
+ *
+ * @details The saved segments are discarded
+ *
+ * @param length The number of segments, 0 to disable the segmented mode
+ *
+ * @return HAL_StatusTypeDef HAL_OK if the length is valid
+ */
+HAL_StatusTypeDef segments_set_length(size_t length);
+
+/**
+ * @brief Check if the segmented mode is enabled
+ *
+ * @return bool True if the segmented mode is enabled, false otherwise
+ */
+bool segments_is_enabled(void);
+
+/**
+ * @brief Discard the saved segments of a single channel
+ *
+ * @param ch The channel to reset
+ */
+void segments_reset(ChartHandlerChannel ch);
+
+/**
+ * @brief Get the number of segments saved for a single channel
+ *
+ * @param ch The channel to check
+ *
+ * @return size_t The number of saved segments
+ */
+size_t segments_get_count(ChartHandlerChannel ch);
+
+/**
+ * @brief Check if every segment of a single channel is saved
+ *
+ * @param ch The channel to check
+ *
+ * @return bool True if no more segments can be saved, false otherwise
+ */
+bool segments_is_full(ChartHandlerChannel ch);
+
+/**
+ * @brief Get the next free segment of a single channel and count it as saved
+ *
+ * @param ch The channel to select
+ *
+ * @return Segment * A pointer to the segment to fill, NULL if every segment is saved
+ */
+Segment * segments_push(ChartHandlerChannel ch);
+
+/**
+ * @brief Get a saved segment of a single channel
+ *
+ * @param ch The channel to select
+ * @param index The index of the segment in order of capture
+ *
+ * @return const Segment * A pointer to the segment, NULL if it is not saved
+ */
+const Segment * segments_get(ChartHandlerChannel ch, size_t index);
+
+#endif  // SEGMENTS_H
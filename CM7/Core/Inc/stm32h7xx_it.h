@@ -63,6 +63,7 @@ void EXTI9_5_IRQHandler(void);
 void EXTI15_10_IRQHandler(void);
 void DMA2D_IRQHandler(void);
 /* USER CODE BEGIN EFP */
+void HSEM1_IRQHandler(void);
 
 /* USER CODE END EFP */
 
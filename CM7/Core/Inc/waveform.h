@@ -0,0 +1,167 @@
+/**
+ * @file waveform.h
+ * @brief Rasterization of the displayed waveforms
+ *
+ * @details Every waveform is drawn as a single vertical span for each column of the
+ * chart into the frame buffer of the LTDC foreground layer, which is transparent
+ * everywhere else, so the cost of a new waveform depends on the width of the chart
+ * and not on the number of values
+ * Only the pixels of the previous and of the new spans are updated, the spans of
+ * the other channel are kept since a pixel is covered by a channel only if it is
+ * inside the span of the same column
+ *
+ * The frame buffer is in L8 format, each pixel is an index of a palette which has
+ * an entry for the color of each channel and an entry for each intensity level of
+ * the persistence of each channel, the transparent entry is removed with the color
+ * keying of the LTDC
+ *
+ * @date Oct 16, 2026
+ * @author Antonio Gelain [antonio.gelain@studenti.unitn.it]
+ */
+
+#ifndef WAVEFORM_H
+#define WAVEFORM_H
+
+#include "main.h"
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+#include "chart_handler.h"
+
+/** @brief Row of a column where no span is drawn */
+#define WAVEFORM_NO_SPAN (-1)
+
+/** @brief Color of the transparent palette entry, used as color key of the LTDC layer */
+#define WAVEFORM_TRANSPARENT (0x000000U)
+
+/** @brief Number of bits of the intensity levels of the persistence */
+#define WAVEFORM_PERSISTENCE_LEVEL_BITS (6U)
+#define WAVEFORM_PERSISTENCE_LEVEL_COUNT (1U << WAVEFORM_PERSISTENCE_LEVEL_BITS)
+
+/**
+ * @brief Palette entries
+ *
+ * @details The transparent entry is followed by the color of each channel and by the
+ * intensity levels of the persistence of each channel
+ */
+#define WAVEFORM_INDEX_TRANSPARENT (0U)
+#define WAVEFORM_INDEX_CHANNEL (WAVEFORM_INDEX_TRANSPARENT + 1U)
+#define WAVEFORM_INDEX_PERSISTENCE (WAVEFORM_INDEX_CHANNEL + CHART_HANDLER_CHANNEL_COUNT)
+#define WAVEFORM_PALETTE_SIZE (256U)
+
+/**
+ * @brief Initialize the waveforms as empty and clear the frame buffer
+ * @attention The SDRAM must be initialized before calling this function
+ */
+void waveform_init(void);
+
+/**
+ * @brief Set the size of the area where the waveforms are drawn
+ *
+ * @details The frame buffer is cleared
+ *
+ * @param width The width of the area in pixels
+ * @param height The height of the area in pixels
+ *
+ * @return HAL_StatusTypeDef HAL_OK if the area fits inside the buffers
+ */
+HAL_StatusTypeDef waveform_set_size(size_t width, size_t height);
+
+/**
+ * @brief Set the color of the waveform and of the persistence of a single channel
+ * @attention The palette has to be loaded again inside the CLUT of the LTDC layer
+ *
+ * @param ch The channel to select
+ * @param color The color in ARGB8888 format, the alpha is ignored
+ */
+void waveform_set_color(ChartHandlerChannel ch, uint32_t color);
+
+/**
+ * @brief Get the palette of the frame buffer
+ *
+ * @details The palette has WAVEFORM_PALETTE_SIZE entries in RGB888 format
+ *
+ * @return uint32_t * A pointer to the palette
+ */
+uint32_t * waveform_get_palette(void);
+
+/**
+ * @brief Get the frame buffer of the LTDC foreground layer
+ *
+ * @details The buffer has an L8 pixel for each pixel of the area stored row by row
+ *
+ * @return uint8_t * A pointer to the frame buffer
+ */
+uint8_t * waveform_get_buffer(void);
+
+/**
+ * @brief Get the first row of the span drawn on each column of a single channel
+ *
+ * @param ch The channel to select
+ *
+ * @return const int16_t * A pointer to the rows, WAVEFORM_NO_SPAN for the empty columns
+ */
+const int16_t * waveform_get_top(ChartHandlerChannel ch);
+
+/**
+ * @brief Get the last row of the span drawn on each column of a single channel
+ *
+ * @param ch The channel to select
+ *
+ * @return const int16_t * A pointer to the rows, WAVEFORM_NO_SPAN for the empty columns
+ */
+const int16_t * waveform_get_bottom(ChartHandlerChannel ch);
+
+/**
+ * @brief Get the width of the area where the waveforms are drawn
+ *
+ * @return size_t The number of columns
+ */
+size_t waveform_get_width(void);
+
+/**
+ * @brief Get the height of the area where the waveforms are drawn
+ *
+ * @return size_t The number of rows
+ */
+size_t waveform_get_height(void);
+
+/**
+ * @brief Redraw the rows whose persistence intensity changed since the last refresh
+ * @attention This function should be called every time the persistence intensities change
+ */
+void waveform_refresh(void);
+
+/**
+ * @brief Erase the waveform of a single channel
+ *
+ * @param ch The channel to clear
+ */
+void waveform_clear(ChartHandlerChannel ch);
+
+/**
+ * @brief Replace the waveform of a single channel
+ *
+ * @details The values are equally spaced along the width of the area and linearly
+ * interpolated between each other, each column is joined to the previous one
+ * When the minimum values are given each column is drawn from the minimum to the
+ * maximum of the nearest value instead
+ *
+ * @param ch The channel to draw
+ * @param values The vertical coordinates of the values, CHART_HANDLER_POINT_NONE for the
+ * values which are not displayed
+ * @param min_values The vertical coordinates of the minimum values, can be NULL
+ * @param count The number of values
+ * @param range The coordinate of the top of the area (the bottom is 0)
+ */
+void waveform_draw(
+    ChartHandlerChannel ch,
+    const int16_t * values,
+    const int16_t * min_values,
+    size_t count,
+    int32_t range
+);
+
+#endif  // WAVEFORM_H
@@ -0,0 +1,963 @@
+/**
+ * @file acquisition.c
+ * @brief Continuous acquisition of the oscilloscope channels
+ *
+ * @details The two ADCs convert the channels simultaneously (or the first channel
+ * interleaved) and never stop, the DMA writes the samples into a circular buffer
+ * which is consumed in halves: while one half is processed the other is filled
+ * The DMA interrupt only queues the completed halves, which are processed later
+ * with the lowest priority so that the interrupt latency stays bounded
+ *
+ * @date Oct 16, 2026
+ * @author Antonio Gelain [antonio.gelain@studenti.unitn.it]
+ */
+
+#include "acquisition.h"
+
+#include <stdbool.h>
+#include <string.h>
+
+#include "block_queue.h"
+#include "config.h"
+#include "record.h"
+
+/**
+ * @brief Acquisition profiles sorted by increasing time scale
+ *
+ * @details The ADC clock runs at 25 MHz, a conversion takes the sampling time plus
+ * half the resolution in bits (and half a cycle) which is multiplied by the oversampling ratio
+ * Every profile outputs 16 bit samples so the conversion to voltage does not change
+ */
+static const AcquisitionProfile profiles[] = {
+    // 12 bit at the maximum rate: (1.5 + 6.5) cycles = 0.32 us
+    {
+        .min_x_scale = 0.f,
+        .resolution = ADC_RESOLUTION_12B,
+        .sampling_time = ADC_SAMPLETIME_1CYCLE_5,
+        .conversion_cycles = 8U,
+        .oversampling_ratio = 1U,
+        .right_shift = ADC_RIGHTBITSHIFT_NONE,
+        .left_shift = ADC_LEFTBITSHIFT_4,
+        .interleaved_delay = ADC_TWOSAMPLINGDELAY_4CYCLES,
+        .min_sample_period = 0.5f
+    },
+    // 14 bit: (8.5 + 7.5) cycles = 0.64 us
+    {
+        .min_x_scale = 200.f,
+        .resolution = ADC_RESOLUTION_14B,
+        .sampling_time = ADC_SAMPLETIME_8CYCLES_5,
+        .conversion_cycles = 16U,
+        .oversampling_ratio = 1U,
+        .right_shift = ADC_RIGHTBITSHIFT_NONE,
+        .left_shift = ADC_LEFTBITSHIFT_2,
+        .interleaved_delay = ADC_TWOSAMPLINGDELAY_8CYCLES,
+        .min_sample_period = 1.f
+    },
+    // The sum of 4 samples at 14 bit is 16 bit: 4 * (16.5 + 7.5) cycles = 3.84 us
+    {
+        .min_x_scale = 1000.f,
+        .resolution = ADC_RESOLUTION_14B,
+        .sampling_time = ADC_SAMPLETIME_16CYCLES_5,
+        .conversion_cycles = 4U * 24U,
+        .oversampling_ratio = 4U,
+        .right_shift = ADC_RIGHTBITSHIFT_NONE,
+        .left_shift = ADC_LEFTBITSHIFT_NONE,
+        .interleaved_delay = ADC_TWOSAMPLINGDELAY_9CYCLES,
+        .min_sample_period = 5.f
+    },
+    // Average of 64 samples at 16 bit: 64 * (32.5 + 8.5) cycles = 104.96 us
+    {
+        .min_x_scale = 10000.f,
+        .resolution = ADC_RESOLUTION_16B,
+        .sampling_time = ADC_SAMPLETIME_32CYCLES_5,
+        .conversion_cycles = 64U * 41U,
+        .oversampling_ratio = 64U,
+        .right_shift = ADC_RIGHTBITSHIFT_6,
+        .left_shift = ADC_LEFTBITSHIFT_NONE,
+        .interleaved_delay = ADC_TWOSAMPLINGDELAY_9CYCLES,
+        .min_sample_period = 110.f
+    }
+};
+#define ACQUISITION_PROFILE_COUNT (sizeof(profiles) / sizeof(profiles[0]))
+
+// Interleaved samples of both channels written by the DMA
+static volatile uint16_t raw_data[CHART_TOTAL_RAW_DATA_WIDTH / sizeof(uint16_t)] DMA_BUFFER;
+
+// Copy of the interleaved block being processed with the slave samples corrected
+static uint16_t matched_data[ACQUISITION_BLOCK_SAMPLE_COUNT * CHART_RAW_DATA_STRIDE];
+
+struct {
+    ADC_HandleTypeDef * hadc;
+    ADC_HandleTypeDef * hadc_slave;
+    TIM_HandleTypeDef * htim_trigger;
+    ChartHandler * chart_handler;
+
+    AcquisitionPacing pacing;
+    AcquisitionMode mode;
+    const AcquisitionProfile * profile;
+    uint32_t trigger_source;
+    bool running;
+    volatile bool calibrating;
+
+    float x_scale; // in us
+    float sample_period; // in us
+    size_t block_count;
+
+    // Correction applied to the slave samples to match the master ADC
+    // and mean of the samples of both ADCs measured at each calibration level
+    float slave_gain;
+    float slave_offset;
+    bool calibrated[ACQUISITION_CALIBRATION_COUNT];
+    float calibration_master[ACQUISITION_CALIBRATION_COUNT];
+    float calibration_slave[ACQUISITION_CALIBRATION_COUNT];
+
+    // Number of core cycles in a microsecond
+    float cycles_per_us;
+
+    // Cycle counter and system tick values when the last block was completed
+    // and time of its completion since the acquisition was initialized
+    uint32_t last_timestamp;
+    uint32_t last_tick;
+    double time; // in us
+    uint32_t dropped_count;
+
+    // Blocks completed by the DMA waiting to be processed
+    BlockQueue queue;
+    // Number of the last completed block and of the last block of the previous run
+    volatile uint32_t sequence;
+    volatile uint32_t start_sequence;
+
+    // Analog watchdogs used to find the blocks that can contain a trigger crossing
+    bool watchdog;
+    bool watchdog_active;
+    uint16_t watchdog_level[CHART_HANDLER_CHANNEL_COUNT];
+    uint32_t watchdog_pending[CHART_HANDLER_CHANNEL_COUNT];
+    bool last_above[CHART_HANDLER_CHANNEL_COUNT];
+
+    // Cycle counter values of the external trigger events not yet placed inside a block
+    uint32_t events[ACQUISITION_EVENT_QUEUE_LENGTH];
+    volatile uint32_t event_head;
+    volatile uint32_t event_tail;
+} hacq;
+
+/**
+ * @brief Get the frequency of the clock that drives the trigger timer
+ *
+ * @return uint32_t The frequency in Hz
+ */
+static uint32_t _acquisition_get_timer_clock(void) {
+    // Timers on APB1 are clocked at twice the bus frequency when the bus is prescaled
+    uint32_t clock = HAL_RCC_GetPCLK1Freq();
+    if ((RCC->D2CFGR & RCC_D2CFGR_D2PPRE1) != RCC_APB1_DIV1)
+        clock *= 2U;
+    return clock;
+}
+
+/**
+ * @brief Get the frequency of the clock of the ADCs
+ *
+ * @details The ADCs are clocked asynchronously by the P output of the PLL2 without prescaler
+ *
+ * @return uint32_t The frequency in Hz
+ */
+static uint32_t _acquisition_get_adc_clock(void) {
+    PLL2_ClocksTypeDef pll2;
+    HAL_RCCEx_GetPLL2ClockFreq(&pll2);
+    return pll2.PLL2_P_Frequency;
+}
+
+/**
+ * @brief Get the value of the cycle counter of the core
+ *
+ * @details The 32 bit counter wraps around every few seconds, which is much longer
+ * than any block, so the difference between two values is always correct
+ *
+ * @return uint32_t The number of cycles
+ */
+static inline uint32_t _acquisition_get_cycles(void) {
+    return DWT->CYCCNT;
+}
+
+/**
+ * @brief Advance the acquisition time up to a value of the cycle counter
+ *
+ * @details The time keeps counting while the blocks are dropped or the acquisition is stopped,
+ * the longer intervals are measured with the system tick since the cycle counter could wrap around
+ *
+ * @param now The current value of the cycle counter
+ *
+ * @return uint32_t The number of cycles since the previous call
+ */
+static uint32_t _acquisition_advance_time(uint32_t now) {
+    const uint32_t cycles = now - hacq.last_timestamp;
+    const uint32_t tick = HAL_GetTick();
+    const uint32_t ms = tick - hacq.last_tick;
+    if (ms >= ACQUISITION_MAX_CYCLE_TIME)
+        hacq.time += ms * 1000.0;
+    else
+        hacq.time += cycles / (double)hacq.cycles_per_us;
+    hacq.last_timestamp = now;
+    hacq.last_tick = tick;
+    return cycles;
+}
+
+/**
+ * @brief Check if every sample the ADC can take is needed to reduce the samples of each value
+ *
+ * @details In peak detect mode a glitch shorter than the time between two samples would be lost,
+ * in high resolution mode the noise is reduced more the more samples are averaged
+ *
+ * @return bool True if the samples are taken at the maximum rate, false otherwise
+ */
+static bool _acquisition_is_full_rate(void) {
+    const ChartHandlerAcquisitionMode mode = chart_handler_get_acquisition_mode(hacq.chart_handler);
+    return mode == CHART_HANDLER_ACQUISITION_PEAK_DETECT || mode == CHART_HANDLER_ACQUISITION_HIGH_RESOLUTION;
+}
+
+/**
+ * @brief Choose the acquisition profile based on the timebase
+ *
+ * @return const AcquisitionProfile * A pointer to the profile to use
+ */
+static const AcquisitionProfile * _acquisition_select_profile(void) {
+    // Without the timer the conversions are as fast as possible
+    if (hacq.pacing == ACQUISITION_PACING_FREE_RUNNING)
+        return &profiles[0U];
+
+    // The hardware oversampling would average the samples before they are reduced
+    const bool full_rate = _acquisition_is_full_rate();
+    const AcquisitionProfile * profile = &profiles[0U];
+    for (size_t i = 1U; i < ACQUISITION_PROFILE_COUNT; ++i) {
+        if (hacq.x_scale >= profiles[i].min_x_scale && (!full_rate || profiles[i].oversampling_ratio == 1U))
+            profile = &profiles[i];
+    }
+    return profile;
+}
+
+/**
+ * @brief Choose how the ADCs are combined based on the enabled channels and the timebase
+ * @attention The profile has to be selected first
+ *
+ * @return AcquisitionMode The mode to use
+ */
+static AcquisitionMode _acquisition_select_mode(void) {
+    // The slave ADC is free only if the second channel is disabled
+    // and the oversampled conversions cannot be interleaved
+    if (chart_handler_is_enabled(hacq.chart_handler, CHART_HANDLER_CHANNEL_2) || hacq.profile->oversampling_ratio > 1U)
+        return ACQUISITION_MODE_SIMULTANEOUS;
+    if (hacq.pacing == ACQUISITION_PACING_FREE_RUNNING)
+        return ACQUISITION_MODE_INTERLEAVED;
+
+    // Interleave at the fastest timebases, where the bandwidth is limited by the sample rate
+    return hacq.profile == &profiles[0U] ? ACQUISITION_MODE_INTERLEAVED : ACQUISITION_MODE_SIMULTANEOUS;
+}
+
+/**
+ * @brief Check if the conversions are triggered by the timer
+ *
+ * @details The interleaved conversions are always continuous because the slave
+ * starts automatically half a conversion after the master
+ *
+ * @return bool True if the timer triggers the conversions, false otherwise
+ */
+static bool _acquisition_is_triggered(void) {
+    return hacq.pacing == ACQUISITION_PACING_TIMER && hacq.mode == ACQUISITION_MODE_SIMULTANEOUS;
+}
+
+/**
+ * @brief Choose the sample period and the block size from the current timebase
+ */
+static void _acquisition_configure_timer(void) {
+    if (!_acquisition_is_triggered()) {
+        // The continuous conversions follow each other, the interleaved ones are half a conversion apart
+        hacq.sample_period = hacq.profile->conversion_cycles / (_acquisition_get_adc_clock() / 1000000.f);
+        if (hacq.mode == ACQUISITION_MODE_INTERLEAVED)
+            hacq.sample_period /= 2.f;
+        hacq.block_count = ACQUISITION_BLOCK_SAMPLE_COUNT;
+        return;
+    }
+
+    // Sample just fast enough to get a fixed number of samples for each value,
+    // or as fast as possible when every sample is reduced
+    const float time_per_value = hacq.x_scale / CHART_HANDLER_VALUES_PER_DIVISION;
+    float period = time_per_value / ACQUISITION_SAMPLES_PER_VALUE;
+    if (_acquisition_is_full_rate() || period < hacq.profile->min_sample_period)
+        period = hacq.profile->min_sample_period;
+
+    // Split the period in prescaler and auto-reload values of the 16 bit timer
+    const float clock = (float)_acquisition_get_timer_clock();
+    const uint32_t ticks = (uint32_t)(period * (clock / 1000000.f) + 0.5f);
+    const uint32_t prescaler = ticks / 65536U + 1U;
+    const uint32_t reload = (ticks + prescaler / 2U) / prescaler;
+
+    // Both values are preloaded and applied at the next update event
+    __HAL_TIM_SET_PRESCALER(hacq.htim_trigger, prescaler - 1U);
+    __HAL_TIM_SET_AUTORELOAD(hacq.htim_trigger, reload - 1U);
+    hacq.sample_period = (prescaler * reload) / (clock / 1000000.f);
+
+    // Keep the blocks short at slow timebases so the chart is updated often
+    size_t count = (size_t)(ACQUISITION_BLOCK_TARGET_TIME / hacq.sample_period);
+    if (count < ACQUISITION_MIN_BLOCK_SAMPLE_COUNT)
+        count = ACQUISITION_MIN_BLOCK_SAMPLE_COUNT;
+    else if (count > ACQUISITION_BLOCK_SAMPLE_COUNT)
+        count = ACQUISITION_BLOCK_SAMPLE_COUNT;
+
+    // Each half must start at the beginning of a cache line for the cache maintenance
+    count &= ~(size_t)(__SCB_DCACHE_LINE_SIZE / sizeof(uint32_t) - 1U);
+    hacq.block_count = count;
+}
+
+/**
+ * @brief Configure both ADCs for the selected dual mode and the current profile
+ * @attention The ADCs must be disabled
+ *
+ * @param mode The ADC dual mode (ADC_DUALMODE_REGSIMULT or ADC_DUALMODE_INTERL)
+ * @param triggered True if the conversions are triggered by the timer, false if they are continuous
+ * @param slave_channel The input channel converted by the slave ADC
+ *
+ * @return HAL_StatusTypeDef HAL_OK if the ADCs were configured correctly
+ */
+static HAL_StatusTypeDef _acquisition_configure_adc(uint32_t mode, bool triggered, uint32_t slave_channel) {
+    // The slave always follows the trigger of the master
+    hacq.hadc->Init.ContinuousConvMode = triggered ? DISABLE : ENABLE;
+    hacq.hadc->Init.ExternalTrigConv = triggered ? hacq.trigger_source : ADC_SOFTWARE_START;
+    hacq.hadc->Init.ExternalTrigConvEdge = triggered ? ADC_EXTERNALTRIGCONVEDGE_RISING : ADC_EXTERNALTRIGCONVEDGE_NONE;
+    hacq.hadc_slave->Init.ContinuousConvMode = hacq.hadc->Init.ContinuousConvMode;
+
+    // Both ADCs must produce the same kind of samples
+    ADC_HandleTypeDef * hadcs[] = { hacq.hadc, hacq.hadc_slave };
+    for (size_t i = 0U; i < 2U; ++i) {
+        ADC_InitTypeDef * init = &hadcs[i]->Init;
+        init->Resolution = hacq.profile->resolution;
+        init->LeftBitShift = hacq.profile->left_shift;
+        init->OversamplingMode = hacq.profile->oversampling_ratio > 1U ? ENABLE : DISABLE;
+        init->Oversampling.Ratio = hacq.profile->oversampling_ratio;
+        init->Oversampling.RightBitShift = hacq.profile->right_shift;
+        init->Oversampling.TriggeredMode = ADC_TRIGGEREDMODE_SINGLE_TRIGGER;
+        init->Oversampling.OversamplingStopReset = ADC_REGOVERSAMPLING_CONTINUED_MODE;
+        if (HAL_ADC_Init(hadcs[i]) != HAL_OK)
+            return HAL_ERROR;
+    }
+
+    // In interleaved mode the slave starts half a conversion later than the master
+    ADC_MultiModeTypeDef multimode = {
+        .Mode = mode,
+        .DualModeData = ADC_DUALMODEDATAFORMAT_32_10_BITS,
+        .TwoSamplingDelay = mode == ADC_DUALMODE_INTERL ? hacq.profile->interleaved_delay : ADC_TWOSAMPLINGDELAY_1CYCLE
+    };
+    if (HAL_ADCEx_MultiModeConfigChannel(hacq.hadc, &multimode) != HAL_OK)
+        return HAL_ERROR;
+
+    ADC_ChannelConfTypeDef config = {
+        .Channel = ACQUISITION_CH1_ADC_CHANNEL,
+        .Rank = ADC_REGULAR_RANK_1,
+        .SamplingTime = hacq.profile->sampling_time,
+        .SingleDiff = ADC_SINGLE_ENDED,
+        .OffsetNumber = ADC_OFFSET_NONE,
+        .Offset = 0U,
+        .OffsetSignedSaturation = DISABLE
+    };
+    if (HAL_ADC_ConfigChannel(hacq.hadc, &config) != HAL_OK)
+        return HAL_ERROR;
+    config.Channel = slave_channel;
+    return HAL_ADC_ConfigChannel(hacq.hadc_slave, &config);
+}
+
+/**
+ * @brief Get the thresholds of the analog watchdogs of a single ADC
+ *
+ * @details The samples are shifted to 16 bit after the comparison, so the level is
+ * converted to the resolution of the current profile
+ * The first watchdog flags the samples above the level while the second one flags the
+ * samples equal to or below it
+ *
+ * @param i The index of the ADC, 0 for the master and 1 for the slave
+ * @param high The upper threshold of the first watchdog
+ * @param low The lower threshold of the second watchdog
+ * @param max The upper threshold of the second watchdog
+ */
+static void _acquisition_get_watchdog_thresholds(size_t i, uint32_t * high, uint32_t * low, uint32_t * max) {
+    const ChartHandlerChannel ch = hacq.mode == ACQUISITION_MODE_INTERLEAVED ? CHART_HANDLER_CHANNEL_1 : (ChartHandlerChannel)i;
+    const uint32_t shift = hacq.profile->left_shift >> ADC_CFGR2_LSHIFT_Pos;
+    *max = (1U << (ADC_RESOLUTION - shift)) - 1U;
+    *high = hacq.watchdog_level[ch] >> shift;
+    *low = *high + 1U > *max ? *max : *high + 1U;
+}
+
+/**
+ * @brief Program the analog watchdogs of both ADCs with the trigger level of their channel
+ * @attention The ADCs must not be converting
+ *
+ * @details The watchdogs compare the samples before the oversampling shift, so they are
+ * used only with the profiles that do not oversample
+ *
+ * @return HAL_StatusTypeDef HAL_OK if the watchdogs were configured correctly
+ */
+static HAL_StatusTypeDef _acquisition_configure_watchdog(void) {
+    const bool interleaved = hacq.mode == ACQUISITION_MODE_INTERLEAVED;
+    hacq.watchdog_active = hacq.watchdog && hacq.profile->oversampling_ratio == 1U;
+    for (size_t ch = 0U; ch < CHART_HANDLER_CHANNEL_COUNT; ++ch)
+        hacq.watchdog_level[ch] = chart_handler_get_trigger(hacq.chart_handler, ch);
+
+    ADC_HandleTypeDef * hadcs[] = { hacq.hadc, hacq.hadc_slave };
+    for (size_t i = 0U; i < CHART_HANDLER_CHANNEL_COUNT; ++i) {
+        uint32_t level, low, max;
+        _acquisition_get_watchdog_thresholds(i, &level, &low, &max);
+        hacq.watchdog_pending[i] = 0U;
+        hacq.last_above[i] = false;
+
+        ADC_AnalogWDGConfTypeDef config = {
+            .WatchdogNumber = ADC_ANALOGWATCHDOG_1,
+            .WatchdogMode = hacq.watchdog_active ? ADC_ANALOGWATCHDOG_SINGLE_REG : ADC_ANALOGWATCHDOG_NONE,
+            .Channel = i == 0U || interleaved ? ACQUISITION_CH1_ADC_CHANNEL : ACQUISITION_CH2_ADC_CHANNEL,
+            .ITMode = DISABLE,
+            .HighThreshold = level,
+            .LowThreshold = 0U
+        };
+        if (HAL_ADC_AnalogWDGConfig(hadcs[i], &config) != HAL_OK)
+            return HAL_ERROR;
+
+        // The second watchdog keeps the channels of the previous calls, so it is cleared first
+        const uint32_t mode = config.WatchdogMode;
+        config.WatchdogNumber = ADC_ANALOGWATCHDOG_2;
+        config.WatchdogMode = ADC_ANALOGWATCHDOG_NONE;
+        if (HAL_ADC_AnalogWDGConfig(hadcs[i], &config) != HAL_OK)
+            return HAL_ERROR;
+
+        config.WatchdogMode = mode;
+        config.HighThreshold = max;
+        config.LowThreshold = low;
+        if (HAL_ADC_AnalogWDGConfig(hadcs[i], &config) != HAL_OK)
+            return HAL_ERROR;
+        __HAL_ADC_CLEAR_FLAG(hadcs[i], ADC_FLAG_AWD1 | ADC_FLAG_AWD2);
+    }
+    return HAL_OK;
+}
+
+/**
+ * @brief Check which channels can cross their trigger level inside a block
+ *
+ * @details A crossing is possible only if there are samples on both sides of the level,
+ * counting the last sample of the previous block as well
+ * The flags are cleared while the DMA is already writing the next block, so they are
+ * counted for the next block too to avoid missing its first samples
+ *
+ * @param block A pointer to the block to check, its crossing flags are updated
+ */
+static void _acquisition_check_watchdog(ChartHandlerBlock * block) {
+    uint32_t flags[CHART_HANDLER_CHANNEL_COUNT] = { 0U };
+
+    // Both ADCs convert the first channel when interleaved
+    ADC_HandleTypeDef * hadcs[] = { hacq.hadc, hacq.hadc_slave };
+    for (size_t i = 0U; i < CHART_HANDLER_CHANNEL_COUNT; ++i) {
+        const uint32_t isr = hadcs[i]->Instance->ISR & (ADC_FLAG_AWD1 | ADC_FLAG_AWD2);
+        __HAL_ADC_CLEAR_FLAG(hadcs[i], isr);
+
+        const size_t ch = hacq.mode == ACQUISITION_MODE_INTERLEAVED ? CHART_HANDLER_CHANNEL_1 : i;
+        flags[ch] |= isr | hacq.watchdog_pending[i];
+        hacq.watchdog_pending[i] = isr;
+    }
+
+    for (size_t ch = 0U; ch < CHART_HANDLER_CHANNEL_COUNT; ++ch) {
+        if (!hacq.watchdog_active) {
+            block->crossing[ch] = true;
+            continue;
+        }
+        const bool above = (flags[ch] & ADC_FLAG_AWD1) || hacq.last_above[ch];
+        const bool below = (flags[ch] & ADC_FLAG_AWD2) || !hacq.last_above[ch];
+        block->crossing[ch] = above && below;
+
+        hacq.last_above[ch] = block->raw[ch][(block->count - 1U) * block->stride] > hacq.watchdog_level[ch];
+    }
+}
+
+/**
+ * @brief Get the half of the circular buffer that the DMA is currently writing
+ *
+ * @return size_t 0 for the first half, 1 for the second half
+ */
+static size_t _acquisition_get_dma_half(void) {
+    const size_t written = 2U * hacq.block_count - __HAL_DMA_GET_COUNTER(hacq.hadc->DMA_Handle);
+    return written < hacq.block_count ? 0U : 1U;
+}
+
+/**
+ * @brief Copy an interleaved block correcting the slave samples so that they match the ones of the master
+ *
+ * @details The samples are copied instead of being corrected in place, otherwise the
+ * dirty cache lines of the circular buffer could be written back over newer samples of the DMA
+ *
+ * @param raw The interleaved samples where the slave ones have odd indices
+ * @param count The number of samples
+ *
+ * @return volatile const uint16_t * A pointer to the corrected copy of the samples
+ */
+static volatile const uint16_t * _acquisition_match_slave(volatile const uint16_t * raw, size_t count) {
+    const float max = (float)((1U << ADC_RESOLUTION) - 1U);
+    for (size_t i = 0U; i + 1U < count; i += 2U) {
+        float value = raw[i + 1U] * hacq.slave_gain + hacq.slave_offset + 0.5f;
+        if (value < 0.f)
+            value = 0.f;
+        else if (value > max)
+            value = max;
+        matched_data[i] = raw[i];
+        matched_data[i + 1U] = (uint16_t)value;
+    }
+    return matched_data;
+}
+
+/**
+ * @brief Publish a single half of the circular buffer so that it is processed later
+ * @attention This function should only be called from the DMA interrupt
+ *
+ * @param half The completed half, 0 for the first half, 1 for the second half
+ */
+static void _acquisition_publish_half(size_t half) {
+    // Elapsed cycles since the previous block, the counter can safely wrap around
+    const uint32_t now = _acquisition_get_cycles();
+    uint32_t dt = _acquisition_advance_time(now);
+    if (dt == 0U)
+        dt = 1U;
+
+    // The other half is being overwritten from now on
+    const uint32_t sequence = hacq.sequence + 1U;
+    hacq.sequence = sequence;
+
+    // The DMA has already wrapped around and it is overwriting the block
+    if (_acquisition_get_dma_half() == half) {
+        ++hacq.dropped_count;
+        return;
+    }
+
+    const BlockQueueItem item = {
+        .raw = &raw_data[half * hacq.block_count * CHART_RAW_DATA_STRIDE],
+        .count = hacq.block_count,
+        .timestamp = now,
+        .elapsed = dt,
+        .time = hacq.time,
+        .sequence = sequence
+    };
+    if (!block_queue_push(&hacq.queue, &item)) {
+        ++hacq.dropped_count;
+        return;
+    }
+
+    // The blocks are processed with the lowest priority once every other interrupt is served
+    SCB->ICSR = SCB_ICSR_PENDSVSET_Msk;
+}
+
+/**
+ * @brief Check if a block is still inside the circular buffer
+ *
+ * @details The DMA starts overwriting a block as soon as the next one is completed
+ *
+ * @param item A pointer to the descriptor of the block
+ *
+ * @return bool True if the block can be used, false otherwise
+ */
+static bool _acquisition_is_block_valid(const BlockQueueItem * item) {
+    return item->sequence == hacq.sequence;
+}
+
+/**
+ * @brief Move the external trigger events that happened during a block inside it
+ *
+ * @details Each event is placed on the first sample taken after it, counting back from
+ * the time the block was completed; the events older than the block are discarded and
+ * the ones that happened after it are kept for the next block
+ *
+ * @param item A pointer to the descriptor of the block
+ * @param block A pointer to the block whose events are updated
+ */
+static void _acquisition_place_events(const BlockQueueItem * item, ChartHandlerBlock * block) {
+    block->event_count = 0U;
+    while (hacq.event_tail != hacq.event_head) {
+        const uint32_t time = hacq.events[hacq.event_tail & (ACQUISITION_EVENT_QUEUE_LENGTH - 1U)];
+        const uint32_t age = item->timestamp - time;
+        if (age > UINT32_MAX / 2U)
+            break;
+        ++hacq.event_tail;
+        if (age >= item->elapsed || block->event_count >= CHART_HANDLER_BLOCK_MAX_EVENTS)
+            continue;
+
+        const size_t back = (size_t)(age / (block->time_per_sample * hacq.cycles_per_us));
+        block->events[block->event_count++] = back < block->count ? block->count - 1U - back : 0U;
+    }
+}
+
+/**
+ * @brief Send a single block to the record and to the chart handler
+ *
+ * @param item A pointer to the descriptor of the block to process
+ */
+static void _acquisition_process_block(const BlockQueueItem * item) {
+    // The blocks of the previous run are discarded without being counted
+    if ((int32_t)(item->sequence - hacq.start_sequence) <= 0)
+        return;
+    if (!_acquisition_is_block_valid(item)) {
+        ++hacq.dropped_count;
+        return;
+    }
+
+    // Each transfer contains two consecutive samples of the first channel when interleaved
+    const bool interleaved = hacq.mode == ACQUISITION_MODE_INTERLEAVED;
+    const size_t count = interleaved ? CHART_RAW_DATA_STRIDE * item->count : item->count;
+
+    // Discard the cached copy of the block since it was written by the DMA
+    const size_t size = item->count * CHART_RAW_DATA_STRIDE * sizeof(uint16_t);
+    SCB_InvalidateDCache_by_Addr((void *)item->raw, size);
+
+    volatile const uint16_t * raw = interleaved ? _acquisition_match_slave(item->raw, count) : item->raw;
+
+    ChartHandlerBlock block = {
+        .raw = {
+            raw,
+            raw + 1U
+        },
+        .stride = interleaved ? 1U : CHART_RAW_DATA_STRIDE,
+        .count = count,
+        .time = item->time - count * (double)hacq.sample_period,
+        .time_per_sample = hacq.sample_period
+    };
+    _acquisition_check_watchdog(&block);
+    _acquisition_place_events(item, &block);
+    record_write(&block);
+    chart_handler_update(hacq.chart_handler, &block);
+
+    // The block was overwritten while it was being processed
+    if (!_acquisition_is_block_valid(item))
+        ++hacq.dropped_count;
+}
+
+HAL_StatusTypeDef acquisition_init(
+    ADC_HandleTypeDef * hadc,
+    ADC_HandleTypeDef * hadc_slave,
+    TIM_HandleTypeDef * htim_trigger,
+    ChartHandler * chart_handler)
+{
+    if (hadc == NULL || hadc_slave == NULL || htim_trigger == NULL || chart_handler == NULL)
+        return HAL_ERROR;
+    hacq.hadc = hadc;
+    hacq.hadc_slave = hadc_slave;
+    hacq.htim_trigger = htim_trigger;
+    hacq.chart_handler = chart_handler;
+
+    hacq.pacing = ACQUISITION_PACING_TIMER;
+    hacq.mode = ACQUISITION_MODE_SIMULTANEOUS;
+    hacq.profile = &profiles[0U];
+    hacq.trigger_source = hadc->Init.ExternalTrigConv;
+    hacq.running = false;
+    hacq.calibrating = false;
+
+    hacq.x_scale = chart_handler_get_timebase(chart_handler);
+    hacq.sample_period = hacq.profile->min_sample_period;
+    hacq.block_count = ACQUISITION_BLOCK_SAMPLE_COUNT;
+
+    hacq.slave_gain = 1.f;
+    hacq.slave_offset = 0.f;
+    for (size_t i = 0U; i < ACQUISITION_CALIBRATION_COUNT; ++i)
+        hacq.calibrated[i] = false;
+
+    // The cycle counter of the core is used to measure the time taken by each block
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    DWT->LAR = 0xC5ACCE55U;
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+    hacq.cycles_per_us = SystemCoreClock / 1000000.f;
+
+    hacq.last_timestamp = _acquisition_get_cycles();
+    hacq.last_tick = HAL_GetTick();
+    hacq.time = 0.0;
+    hacq.dropped_count = 0U;
+
+    block_queue_init(&hacq.queue);
+    hacq.sequence = 0U;
+    hacq.start_sequence = 0U;
+
+    hacq.watchdog = false;
+    hacq.watchdog_active = false;
+
+    hacq.event_head = 0U;
+    hacq.event_tail = 0U;
+
+    // Nothing should be left in the cache before the DMA starts writing the buffer
+    memset((void *)raw_data, 0U, sizeof(raw_data));
+    SCB_CleanInvalidateDCache_by_Addr((uint32_t *)raw_data, sizeof(raw_data));
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef acquisition_start(void) {
+    if (hacq.hadc == NULL)
+        return HAL_ERROR;
+    hacq.profile = _acquisition_select_profile();
+    hacq.mode = _acquisition_select_mode();
+    _acquisition_configure_timer();
+
+    // The recorded samples would not be equally spaced with the new configuration
+    record_reset();
+
+    const bool interleaved = hacq.mode == ACQUISITION_MODE_INTERLEAVED;
+    if (_acquisition_configure_adc(
+        interleaved ? ADC_DUALMODE_INTERL : ADC_DUALMODE_REGSIMULT,
+        _acquisition_is_triggered(),
+        interleaved ? ACQUISITION_CH1_ADC_CHANNEL : ACQUISITION_CH2_ADC_CHANNEL) != HAL_OK)
+        return HAL_ERROR;
+    if (_acquisition_configure_watchdog() != HAL_OK)
+        return HAL_ERROR;
+
+    // The time taken by the first block is measured from now
+    _acquisition_advance_time(_acquisition_get_cycles());
+    hacq.start_sequence = hacq.sequence;
+    hacq.event_tail = hacq.event_head;
+
+    // The DMA is circular so the conversion never stops
+    // Each transfer copies the samples of both ADCs
+    if (HAL_ADCEx_MultiModeStart_DMA(hacq.hadc, (uint32_t *)raw_data, 2U * hacq.block_count) != HAL_OK)
+        return HAL_ERROR;
+
+    if (_acquisition_is_triggered()) {
+        // Load the prescaler and auto-reload values before starting the trigger timer
+        __HAL_TIM_SET_COUNTER(hacq.htim_trigger, 0U);
+        hacq.htim_trigger->Instance->EGR = TIM_EGR_UG;
+        if (HAL_TIM_Base_Start(hacq.htim_trigger) != HAL_OK)
+            return HAL_ERROR;
+    }
+    hacq.running = true;
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef acquisition_stop(void) {
+    if (hacq.hadc == NULL)
+        return HAL_ERROR;
+    hacq.running = false;
+    HAL_TIM_Base_Stop(hacq.htim_trigger);
+    const HAL_StatusTypeDef status = HAL_ADCEx_MultiModeStop_DMA(hacq.hadc);
+
+    // The blocks still inside the queue belong to the old configuration
+    hacq.start_sequence = hacq.sequence;
+    return status;
+}
+
+HAL_StatusTypeDef acquisition_calibrate(AcquisitionCalibrationPoint point) {
+    if (hacq.hadc == NULL || point >= ACQUISITION_CALIBRATION_COUNT)
+        return HAL_ERROR;
+
+    const bool running = hacq.running;
+    if (running && acquisition_stop() != HAL_OK)
+        return HAL_ERROR;
+
+    // Both ADCs convert the first channel interleaved as in the acquisition, the same channel
+    // must not be sampled by both ADCs at the same time
+    // The fastest profile is the one used in interleaved mode
+    hacq.profile = &profiles[0U];
+    if (_acquisition_configure_adc(ADC_DUALMODE_INTERL, false, ACQUISITION_CH1_ADC_CHANNEL) != HAL_OK)
+        return HAL_ERROR;
+    hacq.block_count = ACQUISITION_BLOCK_SAMPLE_COUNT;
+
+    // The sums are exact so the noise of the single samples is averaged over every buffer
+    volatile const uint16_t * raw = raw_data;
+    const size_t count = 2U * hacq.block_count;
+    uint64_t master_sum = 0U;
+    uint64_t slave_sum = 0U;
+    for (size_t n = 0U; n < ACQUISITION_CALIBRATION_BUFFER_COUNT; ++n) {
+        hacq.calibrating = true;
+        if (HAL_ADCEx_MultiModeStart_DMA(hacq.hadc, (uint32_t *)raw_data, count) != HAL_OK) {
+            hacq.calibrating = false;
+            return HAL_ERROR;
+        }
+
+        // Wait until the whole buffer is filled once
+        const uint32_t tick = HAL_GetTick();
+        while (hacq.calibrating && HAL_GetTick() - tick < ACQUISITION_CALIBRATION_TIMEOUT);
+        if (HAL_ADCEx_MultiModeStop_DMA(hacq.hadc) != HAL_OK || hacq.calibrating) {
+            hacq.calibrating = false;
+            return HAL_ERROR;
+        }
+
+        SCB_InvalidateDCache_by_Addr((void *)raw_data, sizeof(raw_data));
+        for (size_t i = 0U; i < count; ++i) {
+            master_sum += raw[CHART_RAW_DATA_STRIDE * i];
+            slave_sum += raw[CHART_RAW_DATA_STRIDE * i + 1U];
+        }
+    }
+
+    // The means are not biased by the noise, unlike a fit of the single samples
+    const double total = (double)count * ACQUISITION_CALIBRATION_BUFFER_COUNT;
+    hacq.calibration_master[point] = (float)(master_sum / total);
+    hacq.calibration_slave[point] = (float)(slave_sum / total);
+    hacq.calibrated[point] = true;
+
+    // The gain is the slope between the two levels, measured only if they are far enough apart
+    HAL_StatusTypeDef status = HAL_OK;
+    if (hacq.calibrated[ACQUISITION_CALIBRATION_LOW] && hacq.calibrated[ACQUISITION_CALIBRATION_HIGH]) {
+        const float master_span = hacq.calibration_master[ACQUISITION_CALIBRATION_HIGH] - hacq.calibration_master[ACQUISITION_CALIBRATION_LOW];
+        const float slave_span = hacq.calibration_slave[ACQUISITION_CALIBRATION_HIGH] - hacq.calibration_slave[ACQUISITION_CALIBRATION_LOW];
+        if (slave_span >= ACQUISITION_CALIBRATION_MIN_SPAN && master_span > 0.f)
+            hacq.slave_gain = master_span / slave_span;
+        else {
+            hacq.calibrated[point] = false;
+            status = HAL_ERROR;
+        }
+    }
+    hacq.slave_offset = hacq.calibration_master[point] - hacq.slave_gain * hacq.calibration_slave[point];
+
+    if (running && acquisition_start() != HAL_OK)
+        return HAL_ERROR;
+    return status;
+}
+
+AcquisitionPacing acquisition_get_pacing(void) {
+    return hacq.pacing;
+}
+
+HAL_StatusTypeDef acquisition_set_pacing(AcquisitionPacing pacing) {
+    if (hacq.hadc == NULL || pacing >= ACQUISITION_PACING_COUNT)
+        return HAL_ERROR;
+    if (pacing == hacq.pacing)
+        return HAL_OK;
+
+    // The ADCs are reconfigured when the acquisition is started again
+    const bool running = hacq.running;
+    if (running && acquisition_stop() != HAL_OK)
+        return HAL_ERROR;
+    hacq.pacing = pacing;
+
+    return running ? acquisition_start() : HAL_OK;
+}
+
+AcquisitionMode acquisition_get_mode(void) {
+    return hacq.mode;
+}
+
+const AcquisitionProfile * acquisition_get_profile(void) {
+    return hacq.profile;
+}
+
+HAL_StatusTypeDef acquisition_set_timebase(float x_scale) {
+    if (hacq.hadc == NULL)
+        return HAL_ERROR;
+    hacq.x_scale = x_scale;
+
+    // The profile and the mode can be changed only while the ADCs are stopped
+    const AcquisitionProfile * profile = hacq.profile;
+    const AcquisitionMode mode = hacq.mode;
+    hacq.profile = _acquisition_select_profile();
+    hacq.mode = _acquisition_select_mode();
+    if (hacq.running && (profile != hacq.profile || mode != hacq.mode)) {
+        if (acquisition_stop() != HAL_OK)
+            return HAL_ERROR;
+        return acquisition_start();
+    }
+
+    const size_t block_count = hacq.block_count;
+    const float sample_period = hacq.sample_period;
+    _acquisition_configure_timer();
+    if (sample_period != hacq.sample_period)
+        record_reset();
+
+    // The DMA has to be restarted to change the length of the circular buffer
+    if (hacq.running && block_count != hacq.block_count) {
+        if (acquisition_stop() != HAL_OK)
+            return HAL_ERROR;
+        return acquisition_start();
+    }
+    return HAL_OK;
+}
+
+bool acquisition_get_trigger_watchdog(void) {
+    return hacq.watchdog;
+}
+
+HAL_StatusTypeDef acquisition_set_trigger_watchdog(bool enabled) {
+    if (hacq.hadc == NULL)
+        return HAL_ERROR;
+    if (enabled == hacq.watchdog)
+        return HAL_OK;
+    hacq.watchdog = enabled;
+    return acquisition_update_trigger_level();
+}
+
+HAL_StatusTypeDef acquisition_update_trigger_level(void) {
+    if (hacq.hadc == NULL)
+        return HAL_ERROR;
+    const bool active = hacq.watchdog && hacq.profile->oversampling_ratio == 1U;
+    if (!hacq.running || (!active && !hacq.watchdog_active))
+        return HAL_OK;
+
+    // The watchdogs can be enabled or disabled only while the ADCs are stopped
+    if (active != hacq.watchdog_active) {
+        if (acquisition_stop() != HAL_OK)
+            return HAL_ERROR;
+        return acquisition_start();
+    }
+
+    // The thresholds are updated while the ADCs are converting
+    for (size_t ch = 0U; ch < CHART_HANDLER_CHANNEL_COUNT; ++ch)
+        hacq.watchdog_level[ch] = chart_handler_get_trigger(hacq.chart_handler, ch);
+    ADC_HandleTypeDef * hadcs[] = { hacq.hadc, hacq.hadc_slave };
+    for (size_t i = 0U; i < CHART_HANDLER_CHANNEL_COUNT; ++i) {
+        uint32_t level, low, max;
+        _acquisition_get_watchdog_thresholds(i, &level, &low, &max);
+        LL_ADC_SetAnalogWDThresholds(
+            hadcs[i]->Instance,
+            LL_ADC_AWD1,
+            LL_ADC_AWD_THRESHOLD_HIGH,
+            ADC_AWD1THRESHOLD_SHIFT_RESOLUTION(hadcs[i], level)
+        );
+        LL_ADC_SetAnalogWDThresholds(
+            hadcs[i]->Instance,
+            LL_ADC_AWD2,
+            LL_ADC_AWD_THRESHOLD_LOW,
+            ADC_AWD23THRESHOLD_SHIFT_RESOLUTION(hadcs[i], low)
+        );
+
+        // The flags raised with the previous thresholds are not reliable, so the next
+        // block is searched anyway
+        hacq.watchdog_pending[i] = ADC_FLAG_AWD1 | ADC_FLAG_AWD2;
+    }
+    return HAL_OK;
+}
+
+float acquisition_get_sample_period(void) {
+    return hacq.sample_period;
+}
+
+uint32_t acquisition_get_dropped_count(void) {
+    return hacq.dropped_count;
+}
+
+void acquisition_routine(void) {
+    BlockQueueItem item;
+    while (block_queue_pop(&hacq.queue, &item))
+        _acquisition_process_block(&item);
+}
+
+void acquisition_half_complete_callback(ADC_HandleTypeDef * hadc) {
+    if (hadc == NULL || hadc->Instance != hacq.hadc->Instance || hacq.calibrating)
+        return;
+    _acquisition_publish_half(0U);
+}
+
+void acquisition_complete_callback(ADC_HandleTypeDef * hadc) {
+    if (hadc == NULL || hadc->Instance != hacq.hadc->Instance)
+        return;
+
+    // The calibration only needs the buffer to be filled once
+    if (hacq.calibrating) {
+        hacq.calibrating = false;
+        return;
+    }
+    _acquisition_publish_half(1U);
+}
+
+void acquisition_add_trigger_event(void) {
+    if (hacq.hadc == NULL || !hacq.running)
+        return;
+    const uint32_t head = hacq.event_head;
+    if (head - hacq.event_tail >= ACQUISITION_EVENT_QUEUE_LENGTH)
+        return;
+
+    // The event must be complete before the consumer can see it
+    hacq.events[head & (ACQUISITION_EVENT_QUEUE_LENGTH - 1U)] = _acquisition_get_cycles();
+    __DMB();
+    hacq.event_head = head + 1U;
+}
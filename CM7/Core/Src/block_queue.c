@@ -0,0 +1,59 @@
+/**
+ * @file block_queue.c
+ * @brief Lock-free queue of the blocks acquired by the DMA
+ *
+ * @details The queue has a single producer (the DMA interrupt) and a single consumer
+ * (the code that processes the blocks), each side only writes its own index so
+ * no critical section is needed
+ * It does not depend on any peripheral so it can be tested on the host as well
+ *
+ * @date Oct 16, 2026
+ * @author Antonio Gelain [antonio.gelain@studenti.unitn.it]
+ */
+
+#include "block_queue.h"
+
+// The indices are never wrapped, only their difference matters
+#define BLOCK_QUEUE_MASK (BLOCK_QUEUE_LENGTH - 1U)
+
+void block_queue_init(BlockQueue * queue) {
+    if (queue == NULL)
+        return;
+    atomic_init(&queue->head, 0U);
+    atomic_init(&queue->tail, 0U);
+}
+
+bool block_queue_push(BlockQueue * queue, const BlockQueueItem * item) {
+    if (queue == NULL || item == NULL)
+        return false;
+    const size_t head = atomic_load_explicit(&queue->head, memory_order_relaxed);
+    const size_t tail = atomic_load_explicit(&queue->tail, memory_order_acquire);
+    if (head - tail >= BLOCK_QUEUE_LENGTH)
+        return false;
+
+    // The descriptor must be complete before the consumer can see it
+    queue->items[head & BLOCK_QUEUE_MASK] = *item;
+    atomic_store_explicit(&queue->head, head + 1U, memory_order_release);
+    return true;
+}
+
+bool block_queue_pop(BlockQueue * queue, BlockQueueItem * item) {
+    if (queue == NULL || item == NULL)
+        return false;
+    const size_t tail = atomic_load_explicit(&queue->tail, memory_order_relaxed);
+    const size_t head = atomic_load_explicit(&queue->head, memory_order_acquire);
+    if (head == tail)
+        return false;
+
+    // The slot can be reused by the producer only after it is copied
+    *item = queue->items[tail & BLOCK_QUEUE_MASK];
+    atomic_store_explicit(&queue->tail, tail + 1U, memory_order_release);
+    return true;
+}
+
+bool block_queue_is_empty(BlockQueue * queue) {
+    if (queue == NULL)
+        return true;
+    return atomic_load_explicit(&queue->head, memory_order_acquire) ==
+        atomic_load_explicit(&queue->tail, memory_order_acquire);
+}
@@ -11,49 +11,1166 @@
 #include <string.h>
 #include <math.h>
 
+#include "acquisition.h"
 #include "config.h"
 #include "lvgl_api.h"
+#include "persistence.h"
+#include "record.h"
+#include "segments.h"
 
-/** @brief Delta used for the trigger threshold to be considered as rising or falling edge */
-#define CHART_HANDLER_TRIGGER_DELTA (100U)
+/** @brief Default hysteresis of the trigger in raw ADC units (20 mV) */
+#define CHART_HANDLER_TRIGGER_DELTA ADC_VOLTAGE_TO_VALUE(20.f)
+
+/** @brief Number of 32 bit words compared before checking the result of the comparison */
+#define CHART_HANDLER_TRIGGER_SCAN_WORDS (4U)
+
+/** @brief How a value is combined with the previous one when the trigger crossing is aligned */
+typedef enum {
+    CHART_HANDLER_ALIGN_INTERPOLATE,
+    CHART_HANDLER_ALIGN_MIN,
+    CHART_HANDLER_ALIGN_MAX
+} ChartHandlerAlign;
+
+// Chart coordinates of every sample with the scale and offset of each channel applied
+static int16_t chart_handler_lut[CHART_HANDLER_CHANNEL_COUNT][CHART_HANDLER_LUT_SIZE] AXI_RAM;
+
+/**
+ * @brief Build the lookup table of the chart coordinates of a single channel
+ * @attention This function should be called every time the scale or the offset changes
+ *
+ * @param handler A pointer to the chart handler structure
+ * @param ch The channel to update
+ */
+static void _chart_handler_update_lut(ChartHandler * handler, ChartHandlerChannel ch) {
+    for (size_t i = 0U; i < CHART_HANDLER_LUT_SIZE; ++i) {
+        // Each entry is converted at the center of the samples it represents
+        const float val = ADC_VALUE_TO_VOLTAGE((i << CHART_HANDLER_LUT_SHIFT) + (1U << CHART_HANDLER_LUT_SHIFT) / 2U);
+        float point = lv_api_grid_units_to_chart(ch, chart_handler_voltage_to_grid_units(handler, ch, val + handler->offset[ch]));
+
+        // Keep the sentinel value free for the values which are not displayed
+        if (point < (float)(INT16_MIN + 1))
+            point = (float)(INT16_MIN + 1);
+        else if (point > (float)INT16_MAX)
+            point = (float)INT16_MAX;
+        chart_handler_lut[ch][i] = (int16_t)point;
+    }
+}
+
+/**
+ * @brief Convert a sample to its chart coordinate
+ *
+ * @param ch The channel of the sample
+ * @param value The raw sample
+ *
+ * @return int16_t The chart coordinate with the scale and offset of the channel applied
+ */
+static inline int16_t _chart_handler_to_chart(ChartHandlerChannel ch, uint16_t value) {
+    return chart_handler_lut[ch][value >> CHART_HANDLER_LUT_SHIFT];
+}
+
+/**
+ * @brief Compare a single sample with a level
+ *
+ * @param sample The sample to compare
+ * @param level The level to compare with
+ * @param above True to check if the sample is above the level, false to check if it is below
+ *
+ * @return bool True if the sample is on the selected side of the level, false otherwise
+ */
+static inline bool _chart_handler_is_past_level(uint16_t sample, uint16_t level, bool above) {
+    return above ? sample > level : sample < level;
+}
+
+/**
+ * @brief Compare a 32 bit word of samples with a level
+ *
+ * @details Both half-words are compared at once, the GE flags set by the subtraction
+ * are turned into a mask of the half-words greater or equal than the threshold
+ *
+ * @param word The two samples to compare
+ * @param threshold The packed level, plus one when checking above the level
+ * @param above True to check if the samples are above the level, false to check if they are below
+ *
+ * @return uint32_t A mask with the half-words on the selected side of the level set
+ */
+static inline uint32_t _chart_handler_past_level_mask(uint32_t word, uint32_t threshold, bool above) {
+    __USUB16(word, threshold);
+    const uint32_t mask = __SEL(0xFFFFFFFFU, 0U);
+    return above ? mask : ~mask;
+}
+
+/**
+ * @brief Find the first sample of a range of a single channel past a level
+ *
+ * @details The samples are read as 32 bit words and CHART_HANDLER_TRIGGER_SCAN_WORDS of
+ * them are compared before a single branch, the exact sample is then found one at a time
+ * only inside the group that contains it
+ *
+ * @param block A pointer to the block of raw samples
+ * @param ch The channel to check
+ * @param start The index of the first sample of the range
+ * @param end The index after the last sample of the range
+ * @param level The level to compare with
+ * @param above True to find a sample above the level, false to find a sample below
+ *
+ * @return size_t The index of the first sample past the level, end if there is none
+ */
+static size_t _chart_handler_find_past_level(
+    const ChartHandlerBlock * block,
+    ChartHandlerChannel ch,
+    size_t start,
+    size_t end,
+    uint16_t level,
+    bool above)
+{
+    // No sample can be past the limits of the range
+    if ((above && level == UINT16_MAX) || (!above && level == 0U))
+        return end;
+    const uint32_t threshold = (above ? level + 1U : level) * 0x00010001U;
+    volatile const uint16_t * raw = block->raw[ch];
+    size_t k = start;
+
+    if (block->stride == CHART_RAW_DATA_STRIDE) {
+        // The first channel is in the lower half-word
+        volatile const uint32_t * words = (volatile const uint32_t *)block->raw[CHART_HANDLER_CHANNEL_1];
+        const uint32_t half = ch == CHART_HANDLER_CHANNEL_1 ? 0x0000FFFFU : 0xFFFF0000U;
+        for (; k + CHART_HANDLER_TRIGGER_SCAN_WORDS <= end; k += CHART_HANDLER_TRIGGER_SCAN_WORDS) {
+            uint32_t mask = 0U;
+            for (size_t n = 0U; n < CHART_HANDLER_TRIGGER_SCAN_WORDS; ++n)
+                mask |= _chart_handler_past_level_mask(words[k + n], threshold, above);
+            if ((mask & half) != 0U)
+                break;
+        }
+    }
+    else {
+        // The sample outside of the word boundaries is compared alone
+        if (k < end && ((uintptr_t)&raw[k] & 2U) != 0U) {
+            if (_chart_handler_is_past_level(raw[k], level, above))
+                return k;
+            ++k;
+        }
+        for (; k + 2U * CHART_HANDLER_TRIGGER_SCAN_WORDS <= end; k += 2U * CHART_HANDLER_TRIGGER_SCAN_WORDS) {
+            volatile const uint32_t * words = (volatile const uint32_t *)&raw[k];
+            uint32_t mask = 0U;
+            for (size_t n = 0U; n < CHART_HANDLER_TRIGGER_SCAN_WORDS; ++n)
+                mask |= _chart_handler_past_level_mask(words[n], threshold, above);
+            if (mask != 0U)
+                break;
+        }
+    }
+
+    // Find the exact sample inside the group or among the remaining ones
+    for (; k < end; ++k) {
+        if (_chart_handler_is_past_level(raw[k * block->stride], level, above))
+            return k;
+    }
+    return end;
+}
+
+/**
+ * @brief Find the first edge inside a range of samples of the trigger source
+ *
+ * @details The signal has to move past the hysteresis band on the opposite side of the
+ * edge before crossing the trigger level, the armed flag is kept between calls so that
+ * the events between two ranges or two blocks are found as well
+ *
+ * @param handler A pointer to the chart handler structure
+ * @param ch The channel whose trigger state is updated
+ * @param src The channel whose samples are checked
+ * @param block A pointer to the block of raw samples
+ * @param start The index of the first sample of the range
+ * @param end The index after the last sample of the range
+ *
+ * @return size_t The index of the first sample after the crossing, end if there is none
+ */
+static size_t _chart_handler_find_edge(
+    ChartHandler * handler,
+    ChartHandlerChannel ch,
+    ChartHandlerChannel src,
+    const ChartHandlerBlock * block,
+    size_t start,
+    size_t end)
+{
+    const bool rising = handler->ascending_trigger;
+    const uint16_t level = handler->trigger[src];
+    const uint16_t hysteresis = handler->trigger_hysteresis;
+
+    // Arm level, clamped so that it can always be reached
+    uint16_t arm = 1U;
+    if (rising && level > hysteresis)
+        arm = level - hysteresis;
+    else if (!rising)
+        arm = (uint32_t)level + hysteresis < UINT16_MAX ? level + hysteresis : UINT16_MAX - 1U;
+
+    size_t k = start;
+    if (!handler->trigger_armed[ch]) {
+        k = _chart_handler_find_past_level(block, src, k, end, arm, !rising);
+        if (k >= end)
+            return end;
+        handler->trigger_armed[ch] = true;
+    }
+    k = _chart_handler_find_past_level(block, src, k, end, level, rising);
+    if (k < end)
+        handler->trigger_armed[ch] = false;
+    return k;
+}
+
+/**
+ * @brief Find the first sample of a range where the signal moves past a level
+ *
+ * @details The signal rises above the level but it falls only below the level minus
+ * the hysteresis, so the noise around the level does not produce many transitions
+ *
+ * @param handler A pointer to the chart handler structure
+ * @param ch The channel to check
+ * @param block A pointer to the block of raw samples
+ * @param start The index of the first sample of the range
+ * @param end The index after the last sample of the range
+ * @param level The level to cross
+ * @param rising True to find a rising transition, false to find a falling one
+ *
+ * @return size_t The index of the first sample after the transition, end if there is none
+ */
+static size_t _chart_handler_find_transition(
+    ChartHandler * handler,
+    ChartHandlerChannel ch,
+    const ChartHandlerBlock * block,
+    size_t start,
+    size_t end,
+    uint16_t level,
+    bool rising)
+{
+    if (rising)
+        return _chart_handler_find_past_level(block, ch, start, end, level, true);
+    const uint16_t low = level > handler->trigger_hysteresis ? level - handler->trigger_hysteresis : 1U;
+    return _chart_handler_find_past_level(block, ch, start, end, low, false);
+}
+
+/**
+ * @brief Get the level crossed by a transition
+ *
+ * @param handler A pointer to the chart handler structure
+ * @param level The level of the transition
+ * @param rising True for a rising transition, false for a falling one
+ *
+ * @return uint16_t The level crossed by the signal
+ */
+static inline uint16_t _chart_handler_transition_level(ChartHandler * handler, uint16_t level, bool rising) {
+    if (rising)
+        return level;
+    return level > handler->trigger_hysteresis ? level - handler->trigger_hysteresis : 1U;
+}
+
+/**
+ * @brief Check if a time satisfies the time condition of the trigger
+ *
+ * @param handler A pointer to the chart handler structure
+ * @param samples The time in samples
+ * @param low The lower limit in samples
+ * @param high The upper limit in samples
+ *
+ * @return bool True if the condition is satisfied, false otherwise
+ */
+static bool _chart_handler_is_time_qualified(ChartHandler * handler, int64_t samples, float low, float high) {
+    switch (handler->trigger_condition) {
+        case CHART_HANDLER_TRIGGER_LESS:
+            return samples < low;
+        case CHART_HANDLER_TRIGGER_GREATER:
+            return samples > low;
+        case CHART_HANDLER_TRIGGER_RANGE:
+            return samples >= low && samples <= high;
+        default:
+            return false;
+    }
+}
+
+/**
+ * @brief Find the first pulse or glitch inside a range of samples of a single channel
+ *
+ * @details The signal is tracked as above or below the trigger level and the time between
+ * two transitions is the width of a pulse: a pulse width event is the end of a pulse of
+ * the selected polarity which satisfies the time condition, a glitch is the end of a pulse
+ * of any polarity narrower than the lower limit
+ * Every step jumps to the next transition so the cost is bounded by the number of samples
+ *
+ * @param handler A pointer to the chart handler structure
+ * @param ch The channel whose trigger state is updated
+ * @param src The channel whose samples are checked
+ * @param block A pointer to the block of raw samples
+ * @param start The index of the first sample of the range
+ * @param end The index after the last sample of the range
+ * @param level A pointer where the level crossed by the event is written
+ *
+ * @return size_t The index of the first sample after the event, end if there is none
+ */
+static size_t _chart_handler_find_pulse(
+    ChartHandler * handler,
+    ChartHandlerChannel ch,
+    ChartHandlerChannel src,
+    const ChartHandlerBlock * block,
+    size_t start,
+    size_t end,
+    uint16_t * level)
+{
+    const bool positive = handler->ascending_trigger;
+    const bool glitch = handler->trigger_type == CHART_HANDLER_TRIGGER_GLITCH;
+    const uint16_t trigger = handler->trigger[src];
+
+    // Limits in samples at the current time scale
+    const float samples_per_division = handler->x_scale[ch] / block->time_per_sample;
+    const float low = handler->trigger_limit_low * samples_per_division;
+    const float high = handler->trigger_limit_high * samples_per_division;
+
+    size_t k = start;
+    if (k >= end)
+        return end;
+    if (!handler->trigger_armed[ch]) {
+        // The width of the first pulse is unknown
+        handler->trigger_inside[ch] = block->raw[src][k * block->stride] > trigger;
+        handler->trigger_timed[ch] = false;
+        handler->trigger_armed[ch] = true;
+    }
+
+    while (k < end) {
+        const bool high_side = handler->trigger_inside[ch];
+        k = _chart_handler_find_transition(handler, src, block, k, end, trigger, !high_side);
+        if (k >= end)
+            break;
+        const bool timed = handler->trigger_timed[ch];
+        const int64_t width = (int64_t)k - handler->trigger_start[ch];
+        handler->trigger_inside[ch] = !high_side;
+        handler->trigger_timed[ch] = true;
+        handler->trigger_start[ch] = (int64_t)k;
+        if (!timed)
+            continue;
+
+        bool event = false;
+        if (glitch)
+            event = width < low;
+        else if (high_side == positive)
+            event = _chart_handler_is_time_qualified(handler, width, low, high);
+        if (event) {
+            handler->trigger_armed[ch] = false;
+            *level = _chart_handler_transition_level(handler, trigger, !high_side);
+            return k;
+        }
+    }
+    return end;
+}
+
+/**
+ * @brief Check if a second level is on the side of the trigger level where the pulses go
+ *
+ * @param handler A pointer to the chart handler structure
+ * @param ch The channel to check
+ * @param value The second level in raw ADC units
+ *
+ * @return bool True if the level is above the trigger level for the ascending polarity
+ * or below it for the descending one, false otherwise
+ */
+static inline bool _chart_handler_is_trigger_second_valid(ChartHandler * handler, ChartHandlerChannel ch, uint16_t value) {
+    return handler->ascending_trigger ? value > handler->trigger[ch] : value < handler->trigger[ch];
+}
+
+/**
+ * @brief Find the first runt pulse or slope inside a range of samples of a single channel
+ *
+ * @details A pulse starts when the signal crosses the trigger level towards the second level,
+ * a runt event is found if the signal goes back without reaching the second level, a slope
+ * event is found when the signal reaches the second level in a time that satisfies the
+ * time condition
+ * Every step jumps to the next transition so the cost is bounded by the number of samples
+ *
+ * @param handler A pointer to the chart handler structure
+ * @param ch The channel whose trigger state is updated
+ * @param src The channel whose samples are checked
+ * @param block A pointer to the block of raw samples
+ * @param start The index of the first sample of the range
+ * @param end The index after the last sample of the range
+ * @param level A pointer where the level crossed by the event is written
+ *
+ * @return size_t The index of the first sample after the event, end if there is none
+ */
+static size_t _chart_handler_find_runt_or_slope(
+    ChartHandler * handler,
+    ChartHandlerChannel ch,
+    ChartHandlerChannel src,
+    const ChartHandlerBlock * block,
+    size_t start,
+    size_t end,
+    uint16_t * level)
+{
+    const bool into = handler->ascending_trigger;
+    const bool runt = handler->trigger_type == CHART_HANDLER_TRIGGER_RUNT;
+    const uint16_t near = handler->trigger[src];
+    const uint16_t far = handler->trigger_second[src];
+
+    // The pulses would reach a second level on the wrong side as soon as they start
+    if (!_chart_handler_is_trigger_second_valid(handler, src, far))
+        return end;
+
+    // Limits in samples at the current time scale
+    const float samples_per_division = handler->x_scale[ch] / block->time_per_sample;
+    const float low = handler->trigger_limit_low * samples_per_division;
+    const float high = handler->trigger_limit_high * samples_per_division;
+
+    size_t k = start;
+    if (!handler->trigger_armed[ch]) {
+        // Wait for the signal to be outside of the pulse
+        k = _chart_handler_find_transition(handler, src, block, k, end, near, !into);
+        if (k >= end)
+            return end;
+        handler->trigger_armed[ch] = true;
+        handler->trigger_inside[ch] = false;
+        handler->trigger_crossed[ch] = false;
+    }
+
+    while (k < end) {
+        if (!handler->trigger_inside[ch]) {
+            k = _chart_handler_find_transition(handler, src, block, k, end, near, into);
+            if (k >= end)
+                break;
+            handler->trigger_inside[ch] = true;
+            handler->trigger_crossed[ch] = false;
+            handler->trigger_start[ch] = (int64_t)k;
+        }
+
+        if (!handler->trigger_crossed[ch]) {
+            // Only the samples before the signal goes back can reach the second level
+            const size_t back = _chart_handler_find_transition(handler, src, block, k, end, near, !into);
+            const size_t over = _chart_handler_find_transition(handler, src, block, k, back, far, into);
+            if (over < back) {
+                handler->trigger_crossed[ch] = true;
+                k = over;
+                if (!runt && _chart_handler_is_time_qualified(handler, (int64_t)k - handler->trigger_start[ch], low, high)) {
+                    handler->trigger_armed[ch] = false;
+                    *level = _chart_handler_transition_level(handler, far, into);
+                    return k;
+                }
+            }
+            else if (back < end) {
+                handler->trigger_inside[ch] = false;
+                k = back;
+                if (runt) {
+                    handler->trigger_armed[ch] = false;
+                    *level = _chart_handler_transition_level(handler, near, !into);
+                    return k;
+                }
+                continue;
+            }
+            else
+                break;
+        }
+
+        // Wait for the end of the pulse
+        k = _chart_handler_find_transition(handler, src, block, k, end, near, !into);
+        if (k >= end)
+            break;
+        handler->trigger_inside[ch] = false;
+    }
+    return end;
+}
+
+/**
+ * @brief Find the first external trigger event inside a range of samples
+ *
+ * @param block A pointer to the block of raw samples
+ * @param start The index of the first sample of the range
+ * @param end The index after the last sample of the range
+ *
+ * @return size_t The index of the first sample after the event, end if there is none
+ */
+static size_t _chart_handler_find_event(const ChartHandlerBlock * block, size_t start, size_t end) {
+    for (size_t e = 0U; e < block->event_count; ++e) {
+        if (block->events[e] >= start && block->events[e] < end)
+            return block->events[e];
+    }
+    return end;
+}
+
+/**
+ * @brief Find the first trigger event inside a range of samples of the trigger source
+ *
+ * @param handler A pointer to the chart handler structure
+ * @param ch The channel whose trigger state is updated
+ * @param src The channel whose samples are checked
+ * @param block A pointer to the block of raw samples
+ * @param start The index of the first sample of the range
+ * @param end The index after the last sample of the range
+ * @param level A pointer where the level crossed by the event is written
+ *
+ * @return size_t The index of the first sample after the event, end if there is none
+ */
+static size_t _chart_handler_find_trigger(
+    ChartHandler * handler,
+    ChartHandlerChannel ch,
+    ChartHandlerChannel src,
+    const ChartHandlerBlock * block,
+    size_t start,
+    size_t end,
+    uint16_t * level)
+{
+    switch (handler->trigger_type) {
+        case CHART_HANDLER_TRIGGER_PULSE_WIDTH:
+        case CHART_HANDLER_TRIGGER_GLITCH:
+            return _chart_handler_find_pulse(handler, ch, src, block, start, end, level);
+        case CHART_HANDLER_TRIGGER_RUNT:
+        case CHART_HANDLER_TRIGGER_SLOPE:
+            return _chart_handler_find_runt_or_slope(handler, ch, src, block, start, end, level);
+        default:
+            *level = handler->trigger[src];
+            return _chart_handler_find_edge(handler, ch, src, block, start, end);
+    }
+}
+
+/**
+ * @brief Check if a block can contain a trigger event of a single channel
+ *
+ * @details Once armed an edge cannot happen if the samples do not cross the trigger level
+ * and an external trigger cannot happen if no event was placed inside the block, so the
+ * values of the other blocks are taken without searching their samples
+ *
+ * @param handler A pointer to the chart handler structure
+ * @param ch The channel to check
+ * @param block A pointer to the block of raw samples
+ *
+ * @return bool True if the block has to be searched, false otherwise
+ */
+static bool _chart_handler_block_can_trigger(ChartHandler * handler, ChartHandlerChannel ch, const ChartHandlerBlock * block) {
+    const ChartHandlerChannel src = chart_handler_get_trigger_channel(handler);
+    if (src >= CHART_HANDLER_CHANNEL_COUNT)
+        return block->event_count > 0U;
+    return handler->trigger_type != CHART_HANDLER_TRIGGER_EDGE || block->crossing[src] || !handler->trigger_armed[ch];
+}
+
+/**
+ * @brief Search a trigger event inside a range of samples of a single channel
+ *
+ * @details The samples inside the holdoff time of the previous event are skipped and the
+ * holdoff time restarts from the new event
+ * The events are searched in the trigger source, so both channels are aligned on the same
+ * events; the exact position of a crossing of a source channel is found by linear
+ * interpolation between the two samples around the trigger level
+ *
+ * @param handler A pointer to the chart handler structure
+ * @param ch The channel to check
+ * @param block A pointer to the block of raw samples
+ * @param start The index of the first sample of the range
+ * @param end The index after the last sample of the range
+ *
+ * @return bool True if a trigger event is found, false otherwise
+ */
+static bool _chart_handler_search_trigger(
+    ChartHandler * handler,
+    ChartHandlerChannel ch,
+    const ChartHandlerBlock * block,
+    size_t start,
+    size_t end)
+{
+    if (handler->trigger_holdoff_left[ch] > 0.f) {
+        const float first = ceilf(handler->trigger_holdoff_left[ch] / block->time_per_sample);
+        if (first >= (float)end)
+            return false;
+        if ((size_t)first > start)
+            start = (size_t)first;
+    }
+    if (start >= end)
+        return false;
+
+    // The external events are already aligned to the samples
+    const ChartHandlerChannel src = chart_handler_get_trigger_channel(handler);
+    if (src >= CHART_HANDLER_CHANNEL_COUNT) {
+        const size_t k = _chart_handler_find_event(block, start, end);
+        if (k >= end)
+            return false;
+        handler->trigger_holdoff_left[ch] = handler->trigger_holdoff + k * block->time_per_sample;
+        handler->trigger_crossing[ch] = (float)k;
+        return true;
+    }
+
+    uint16_t level = handler->trigger[src];
+    const size_t k = _chart_handler_find_trigger(handler, ch, src, block, start, end, &level);
+    if (k >= end)
+        return false;
+    handler->trigger_holdoff_left[ch] = handler->trigger_holdoff + k * block->time_per_sample;
+
+    // The sample before the first one of the block is not available anymore
+    handler->trigger_crossing[ch] = (float)k;
+    if (k > 0U) {
+        const float prev = block->raw[src][(k - 1U) * block->stride];
+        const float cur = block->raw[src][k * block->stride];
+        const float t = (level - prev) / (cur - prev);
+        if (t >= 0.f && t <= 1.f)
+            handler->trigger_crossing[ch] = (k - 1U) + t;
+    }
+    return true;
+}
 
 /**
- * @brief Check if a rising edge is found in the signal
+ * @brief Copy the values of a frame with the trigger crossing aligned
  *
- * @param prev The previous value of the signal
- * @param cur The current value of the signal
- * @param trigger The treshold used to check for the rising edge
+ * @details Each value is linearly interpolated with the previous one by the distance between
+ * the crossing and the trigger value, so stable periodic signals do not jitter by a fraction
+ * of a value from frame to frame
+ * The minimum and maximum values of the peak detection are not interpolated, the union of the
+ * two values the crossing falls between is taken instead so no peak is ever lost
+ * The values are copied starting from the newest one, so the ring can be aligned in place
+ * The oldest value has no previous value and is kept as it is
  *
- * @return bool True if a rising edge is found, false otherwise
+ * @param raw The values of the ring
+ * @param out The array where the values are copied
+ * @param index The display index of the first raw value
+ * @param out_index The display index of the first value of the output array, 0 to copy in display order
+ * @param weight The weight of the previous value with 8 fractional bits
+ * @param align How each value is combined with the previous one
  */
-inline bool _chart_handler_is_rising_edge(uint16_t prev, uint16_t cur, uint16_t trigger) {
-    return prev <= trigger && cur > trigger;
+static void _chart_handler_copy_aligned(
+    const uint16_t * raw,
+    uint16_t * out,
+    size_t index,
+    size_t out_index,
+    uint32_t weight,
+    ChartHandlerAlign align)
+{
+    for (size_t d = CHART_HANDLER_VALUES_COUNT; d-- > 0U;) {
+        const size_t i = (d - index + CHART_HANDLER_VALUES_COUNT) % CHART_HANDLER_VALUES_COUNT;
+        const size_t o = (d - out_index + CHART_HANDLER_VALUES_COUNT) % CHART_HANDLER_VALUES_COUNT;
+        const size_t p = (i + CHART_HANDLER_VALUES_COUNT - 1U) % CHART_HANDLER_VALUES_COUNT;
+        if (d == 0U || weight == 0U)
+            out[o] = raw[i];
+        else if (align == CHART_HANDLER_ALIGN_MIN)
+            out[o] = raw[i] < raw[p] ? raw[i] : raw[p];
+        else if (align == CHART_HANDLER_ALIGN_MAX)
+            out[o] = raw[i] > raw[p] ? raw[i] : raw[p];
+        else
+            out[o] = (uint16_t)((raw[i] * (256U - weight) + raw[p] * weight + 128U) >> 8U);
+    }
 }
 
 /**
- * @brief Check if a falling edge is found in the signal
+ * @brief Move the values of a frame so that the trigger crossing is exactly on the trigger value
  *
- * @param prev The previous value of the signal
- * @param cur The current value of the signal
- * @param trigger The treshold used to check for the falling edge
+ * @param handler A pointer to the chart handler structure
+ * @param ch The channel to align
+ * @param index The display index of the first raw value
+ */
+static void _chart_handler_align_trigger(ChartHandler * handler, ChartHandlerChannel ch, size_t index) {
+    // Weight of the previous value with 8 fractional bits
+    const uint32_t weight = (uint32_t)(handler->trigger_fraction[ch] * 256.f + 0.5f);
+    if (weight == 0U)
+        return;
+
+    _chart_handler_copy_aligned(handler->raw[ch], handler->raw[ch], index, index, weight, CHART_HANDLER_ALIGN_INTERPOLATE);
+    if (handler->acquisition_mode == CHART_HANDLER_ACQUISITION_PEAK_DETECT) {
+        _chart_handler_copy_aligned(handler->raw_min[ch], handler->raw_min[ch], index, index, weight, CHART_HANDLER_ALIGN_MIN);
+        _chart_handler_copy_aligned(handler->raw_max[ch], handler->raw_max[ch], index, index, weight, CHART_HANDLER_ALIGN_MAX);
+    }
+}
+
+/**
+ * @brief Start searching a new trigger event for a single channel
  *
- * @return bool True if a falling edge is found, false otherwise
+ * @param handler A pointer to the chart handler structure
+ * @param ch The channel to reset
  */
-inline bool _chart_handler_is_falling_edge(uint16_t prev, uint16_t cur, uint16_t trigger) {
-    return prev >= trigger && cur < trigger;
+static void _chart_handler_reset_trigger(ChartHandler * handler, ChartHandlerChannel ch) {
+    handler->trigger_state[ch] = CHART_HANDLER_TRIGGER_STATE_PRE_TRIGGER;
+    handler->trigger_armed[ch] = false;
+    handler->trigger_inside[ch] = false;
+    handler->trigger_crossed[ch] = false;
+    handler->trigger_timed[ch] = false;
+    handler->trigger_pending[ch] = false;
+    handler->trigger_forced[ch] = false;
+    handler->trigger_wait[ch] = 0.f;
+    handler->trigger_before_count[ch] = 0U;
+    handler->trigger_after_count[ch] = 0U;
+}
+
+/**
+ * @brief Get the number of values displayed before the trigger value
+ *
+ * @param handler A pointer to the chart handler structure
+ *
+ * @return size_t The display index of the trigger value when there is no delay
+ */
+static size_t _chart_handler_pre_trigger_count(ChartHandler * handler) {
+    const size_t count = (size_t)(handler->trigger_position * CHART_HANDLER_VALUES_COUNT / 100.f + 0.5f);
+    return count < CHART_HANDLER_VALUES_COUNT ? count : CHART_HANDLER_VALUES_COUNT - 1U;
+}
+
+/**
+ * @brief Get the delay between the trigger and the displayed values of a single channel
+ *
+ * @param handler A pointer to the chart handler structure
+ * @param ch The channel to check
+ *
+ * @return size_t The delay in values at the current time scale
+ */
+static size_t _chart_handler_delay_count(ChartHandler * handler, ChartHandlerChannel ch) {
+    const float time_per_value = handler->x_scale[ch] / CHART_HANDLER_VALUES_PER_DIVISION;
+    return (size_t)(handler->trigger_delay / time_per_value + 0.5f);
 }
 
 /**
  * @brief Check if the signal data is ready to be plotted
  *
  * @param chart_handler A pointer to the chart handler structure
- * @param count The number of values taken after the signal crosses the trigger
- * @param index The index of the array where the data of the signal is stored
+ * @param ch The channel to check
+ * @param count The number of values required after the trigger, trigger value included
  */
-inline bool _chart_handler_is_data_ready(ChartHandler * handler, size_t count, size_t index) {
+static inline bool _chart_handler_is_data_ready(ChartHandler * handler, ChartHandlerChannel ch, size_t count) {
     return chart_handler_is_trigger_enabled(handler) ?
-        (count >= CHART_HANDLER_VALUES_COUNT / 2) :
-        (index >= CHART_HANDLER_VALUES_COUNT);
+        (handler->trigger_state[ch] == CHART_HANDLER_TRIGGER_STATE_TRIGGERED && handler->trigger_after_count[ch] >= count) :
+        (handler->index[ch] >= CHART_HANDLER_VALUES_COUNT);
+}
+
+/**
+ * @brief Get the display index of the first raw value of a single channel
+ *
+ * @details The delay moves the trigger value to the left and the ring only keeps the
+ * last values so the rotation is the same after many turns
+ *
+ * @param handler A pointer to the chart handler structure
+ * @param ch The channel to check
+ *
+ * @return size_t The display index of the first raw value
+ */
+static size_t _chart_handler_display_index(ChartHandler * handler, ChartHandlerChannel ch) {
+    if (!chart_handler_is_trigger_enabled(handler))
+        return 0U;
+    const int64_t trigger_offset = (int64_t)_chart_handler_pre_trigger_count(handler) - (int64_t)handler->trigger_delay_count[ch];
+    const int64_t rotation = (trigger_offset - handler->trigger_index[ch]) % (int64_t)CHART_HANDLER_VALUES_COUNT;
+    return (size_t)(rotation < 0 ? rotation + CHART_HANDLER_VALUES_COUNT : rotation);
+}
+
+/**
+ * @brief Save the frame of a single channel into the next segment
+ *
+ * @param handler A pointer to the chart handler structure
+ * @param ch The channel to save
+ */
+static void _chart_handler_save_segment(ChartHandler * handler, ChartHandlerChannel ch) {
+    Segment * segment = segments_push(ch);
+    if (segment == NULL)
+        return;
+    const size_t index = _chart_handler_display_index(handler, ch);
+    const uint32_t weight = (uint32_t)(handler->trigger_fraction[ch] * 256.f + 0.5f);
+
+    segment->timestamp = handler->trigger_time[ch];
+    _chart_handler_copy_aligned(handler->raw[ch], segment->raw, index, 0U, weight, CHART_HANDLER_ALIGN_INTERPOLATE);
+    if (handler->acquisition_mode == CHART_HANDLER_ACQUISITION_PEAK_DETECT) {
+        _chart_handler_copy_aligned(handler->raw_min[ch], segment->raw_min, index, 0U, weight, CHART_HANDLER_ALIGN_MIN);
+        _chart_handler_copy_aligned(handler->raw_max[ch], segment->raw_max, index, 0U, weight, CHART_HANDLER_ALIGN_MAX);
+    }
+}
+
+/**
+ * @brief Arm the trigger of a single channel again right after a segment is saved
+ *
+ * @details The values before the trigger are already inside the ring and the event finders
+ * are disarmed after every event, so the next event can be searched from the next value
+ *
+ * @param handler A pointer to the chart handler structure
+ * @param ch The channel to arm
+ * @param before The number of values needed before the trigger
+ */
+static void _chart_handler_rearm_trigger(ChartHandler * handler, ChartHandlerChannel ch, size_t before) {
+    handler->trigger_state[ch] = CHART_HANDLER_TRIGGER_STATE_ARMED;
+    handler->trigger_pending[ch] = false;
+    handler->trigger_wait[ch] = 0.f;
+    handler->trigger_before_count[ch] = before;
+    handler->trigger_after_count[ch] = 0U;
+}
+
+/**
+ * @brief Display the selected segments of a single channel
+ *
+ * @details In overlay mode every segment is drawn into the persistence buffer and the
+ * last one is left on the chart
+ *
+ * @param handler A pointer to the chart handler structure
+ * @param ch The channel to display
+ */
+static void _chart_handler_show_segments(ChartHandler * handler, ChartHandlerChannel ch) {
+    const size_t count = segments_get_count(ch);
+    const bool peak = handler->acquisition_mode == CHART_HANDLER_ACQUISITION_PEAK_DETECT;
+
+    size_t first = 0U;
+    if (handler->segment_view == CHART_HANDLER_SEGMENT_OVERLAY)
+        persistence_clear(ch);
+    else
+        first = handler->segment_view < count ? handler->segment_view : count - 1U;
+    const size_t last = handler->segment_view == CHART_HANDLER_SEGMENT_OVERLAY ? count : first + 1U;
+
+    for (size_t s = first; s < last; ++s) {
+        const Segment * segment = segments_get(ch, s);
+        const uint16_t * raw = peak ? segment->raw_max : segment->raw;
+        for (size_t i = 0U; i < CHART_HANDLER_VALUES_COUNT; ++i) {
+            handler->data[ch][i] = _chart_handler_to_chart(ch, raw[i]);
+            if (peak)
+                handler->data_min[ch][i] = _chart_handler_to_chart(ch, segment->raw_min[i]);
+        }
+        lv_api_update_points(handler->api, ch, handler->data[ch], peak ? handler->data_min[ch] : NULL, CHART_HANDLER_VALUES_COUNT);
+    }
+    lv_api_update_segment_text(handler->api);
+}
+
+/**
+ * @brief Forget the minimum, maximum and sum of the samples taken since the last value
+ *
+ * @param handler A pointer to the chart handler structure
+ * @param ch The channel to reset
+ */
+static void _chart_handler_reset_peaks(ChartHandler * handler, ChartHandlerChannel ch) {
+    handler->peak_min[ch] = UINT16_MAX;
+    handler->peak_max[ch] = 0U;
+    handler->high_resolution_sum[ch] = 0U;
+    handler->high_resolution_count[ch] = 0U;
+}
+
+/**
+ * @brief Update the packed minimum and maximum with a 32 bit word of samples
+ *
+ * @details Both half-words are compared at once, the GE flags set by the subtraction
+ * select the smallest and the largest half-words
+ *
+ * @param word The two samples to compare
+ * @param min A pointer to the packed minimum values
+ * @param max A pointer to the packed maximum values
+ */
+static inline void _chart_handler_fold_peaks(uint32_t word, uint32_t * min, uint32_t * max) {
+    __USUB16(word, *min);
+    *min = __SEL(*min, word);
+    __USUB16(word, *max);
+    *max = __SEL(word, *max);
+}
+
+/**
+ * @brief Update the minimum and maximum with a range of samples of a single channel
+ *
+ * @details The samples are read as 32 bit words and two of them are compared at once:
+ * each word contains the samples of both channels when the stride is 2, or two
+ * consecutive samples of the same channel when the stride is 1
+ *
+ * @param block A pointer to the block of raw samples
+ * @param ch The channel to check
+ * @param start The index of the first sample of the range
+ * @param end The index after the last sample of the range
+ * @param min A pointer to the minimum value which is updated
+ * @param max A pointer to the maximum value which is updated
+ */
+static void _chart_handler_find_peaks(
+    const ChartHandlerBlock * block,
+    ChartHandlerChannel ch,
+    size_t start,
+    size_t end,
+    uint16_t * min,
+    uint16_t * max)
+{
+    if (start >= end)
+        return;
+    uint32_t lo = ((uint32_t)*min << 16U) | *min;
+    uint32_t hi = ((uint32_t)*max << 16U) | *max;
+
+    if (block->stride == CHART_RAW_DATA_STRIDE) {
+        // The first channel is in the lower half-word
+        volatile const uint32_t * words = (volatile const uint32_t *)block->raw[CHART_HANDLER_CHANNEL_1];
+        for (size_t k = start; k < end; ++k)
+            _chart_handler_fold_peaks(words[k], &lo, &hi);
+
+        const uint32_t shift = ch == CHART_HANDLER_CHANNEL_1 ? 0U : 16U;
+        *min = (uint16_t)(lo >> shift);
+        *max = (uint16_t)(hi >> shift);
+        return;
+    }
+
+    // The samples outside of the word boundaries are compared with themselves
+    volatile const uint16_t * raw = block->raw[ch];
+    if (((uintptr_t)&raw[start] & 2U) != 0U) {
+        _chart_handler_fold_peaks(raw[start] * 0x00010001U, &lo, &hi);
+        ++start;
+    }
+    if (start < end && ((end - start) & 1U) != 0U) {
+        --end;
+        _chart_handler_fold_peaks(raw[end] * 0x00010001U, &lo, &hi);
+    }
+    volatile const uint32_t * words = (volatile const uint32_t *)&raw[start];
+    for (size_t k = 0U; k < (end - start) / 2U; ++k)
+        _chart_handler_fold_peaks(words[k], &lo, &hi);
+
+    // Merge the two half-words
+    const uint16_t lo_low = (uint16_t)lo, lo_high = (uint16_t)(lo >> 16U);
+    const uint16_t hi_low = (uint16_t)hi, hi_high = (uint16_t)(hi >> 16U);
+    *min = lo_low < lo_high ? lo_low : lo_high;
+    *max = hi_low > hi_high ? hi_low : hi_high;
+}
+
+/**
+ * @brief Add a range of samples of a single channel to a sum
+ *
+ * @details The samples are read as 32 bit words and both half-words are multiplied and
+ * accumulated by a single instruction into a 64 bit sum, the half-word of the other
+ * channel is multiplied by 0 when the stride is 2
+ * The instruction works on signed half-words so the samples are offset by half of their range
+ *
+ * @param block A pointer to the block of raw samples
+ * @param ch The channel to sum
+ * @param start The index of the first sample of the range
+ * @param end The index after the last sample of the range
+ * @param sum A pointer to the sum which is updated
+ */
+static void _chart_handler_sum(
+    const ChartHandlerBlock * block,
+    ChartHandlerChannel ch,
+    size_t start,
+    size_t end,
+    uint64_t * sum)
+{
+    if (start >= end)
+        return;
+    const size_t count = end - start;
+    uint64_t acc = 0U;
+
+    if (block->stride == CHART_RAW_DATA_STRIDE) {
+        // The first channel is in the lower half-word
+        volatile const uint32_t * words = (volatile const uint32_t *)block->raw[CHART_HANDLER_CHANNEL_1];
+        const uint32_t weight = ch == CHART_HANDLER_CHANNEL_1 ? 0x00000001U : 0x00010000U;
+        for (size_t k = start; k < end; ++k)
+            acc = __SMLALD(words[k] ^ 0x80008000U, weight, acc);
+    }
+    else {
+        // The samples outside of the word boundaries are added one at a time
+        volatile const uint16_t * raw = block->raw[ch];
+        if (((uintptr_t)&raw[start] & 2U) != 0U) {
+            acc = __SMLALD(raw[start] ^ 0x8000U, 0x00000001U, acc);
+            ++start;
+        }
+        if (start < end && ((end - start) & 1U) != 0U) {
+            --end;
+            acc = __SMLALD(raw[end] ^ 0x8000U, 0x00000001U, acc);
+        }
+        volatile const uint32_t * words = (volatile const uint32_t *)&raw[start];
+        for (size_t k = 0U; k < (end - start) / 2U; ++k)
+            acc = __SMLALD(words[k] ^ 0x80008000U, 0x00010001U, acc);
+    }
+
+    // Remove the offset of the samples
+    *sum += acc + (uint64_t)count * 0x8000U;
+}
+
+/**
+ * @brief Add a new value to the exponential average of a single point
+ *
+ * @details Each new value only costs a subtraction, a shift and an addition
+ *
+ * @param acc A pointer to the accumulator with CHART_HANDLER_AVERAGE_FRACTION_BITS fractional bits
+ * @param value The new raw value
+ * @param shift The base 2 logarithm of the inverse of the weight of the new value
+ *
+ * @return uint16_t The averaged raw value rounded to the nearest integer
+ */
+static inline uint16_t _chart_handler_average(int32_t * acc, uint16_t value, uint32_t shift) {
+    *acc += (((int32_t)value << CHART_HANDLER_AVERAGE_FRACTION_BITS) - *acc) >> shift;
+    return (uint16_t)((*acc + (1 << (CHART_HANDLER_AVERAGE_FRACTION_BITS - 1U))) >> CHART_HANDLER_AVERAGE_FRACTION_BITS);
+}
+
+/**
+ * @brief Check if the equivalent-time sampling is used for a single channel
+ *
+ * @param handler A pointer to the chart handler structure
+ * @param ch The channel to check
+ * @param time_per_sample The time between two consecutive samples in us
+ *
+ * @return bool True if the ADC is too slow for the time scale of the channel, false otherwise
+ */
+static bool _chart_handler_is_equivalent_time(ChartHandler * handler, ChartHandlerChannel ch, float time_per_sample) {
+    const float time_per_value = handler->x_scale[ch] / CHART_HANDLER_VALUES_PER_DIVISION;
+    // Only the edges of a channel repeat at the same point of the signal
+    return handler->equivalent_time &&
+        !segments_is_enabled() &&
+        chart_handler_is_trigger_enabled(handler) &&
+        handler->trigger_type == CHART_HANDLER_TRIGGER_EDGE &&
+        chart_handler_get_trigger_channel(handler) < CHART_HANDLER_CHANNEL_COUNT &&
+        time_per_value < time_per_sample;
+}
+
+/**
+ * @brief Start a new equivalent-time frame of a single channel
+ *
+ * @details The values of the previous frame are kept until they are filled again
+ *
+ * @param handler A pointer to the chart handler structure
+ * @param ch The channel to reset
+ */
+static void _chart_handler_reset_equivalent_time(ChartHandler * handler, ChartHandlerChannel ch) {
+    memset(handler->filled[ch], 0U, sizeof(handler->filled[ch]));
+    handler->filled_count[ch] = 0U;
+    handler->acquisition_count[ch] = 0U;
+}
+
+/**
+ * @brief Merge the samples around every trigger crossing of the block into the current frame
+ *
+ * @details The signal is not synchronized with the ADC so each crossing happens at a random
+ * time between two samples, its position is found by linear interpolation and the samples
+ * are placed on the chart relative to it, filling the values between the samples of the
+ * previous crossings
+ *
+ * @param handler A pointer to the chart handler structure
+ * @param ch The channel to update
+ * @param block A pointer to the block of raw samples to process
+ */
+static void _chart_handler_update_equivalent_time(ChartHandler * handler, ChartHandlerChannel ch, const ChartHandlerBlock * block) {
+    const float time_per_value = handler->x_scale[ch] / CHART_HANDLER_VALUES_PER_DIVISION;
+    // Number of values between two samples, always greater than one
+    const float values_per_sample = block->time_per_sample / time_per_value;
+    const size_t pre = _chart_handler_pre_trigger_count(handler);
+    const float position = (float)pre;
+    const ChartHandlerChannel src = chart_handler_get_trigger_channel(handler);
+    const float trigger = handler->trigger[src];
+
+    for (size_t k = 1U; k < block->count; ++k) {
+        k = _chart_handler_find_edge(handler, ch, src, block, k, block->count);
+        if (k >= block->count)
+            break;
+        const uint16_t prev = block->raw[src][(k - 1U) * block->stride];
+        const uint16_t cur = block->raw[src][k * block->stride];
+
+        // Position of the crossing in samples from the start of the block
+        const float crossing = (k - 1U) + (trigger - prev) / ((float)cur - prev);
+
+        // Place the samples with the crossing at the trigger position
+        const float first = crossing - (position + 0.5f) / values_per_sample;
+        for (size_t j = first < 0.f ? 0U : (size_t)ceilf(first); j < block->count; ++j) {
+            const size_t i = (size_t)(position + ((float)j - crossing) * values_per_sample + 0.5f);
+            if (i >= CHART_HANDLER_VALUES_COUNT)
+                break;
+
+            handler->raw[ch][i] = block->raw[ch][j * block->stride];
+            if (!handler->filled[ch][i]) {
+                handler->filled[ch][i] = true;
+                ++handler->filled_count[ch];
+            }
+        }
+        ++handler->acquisition_count[ch];
+
+        // Display the frame when every value is filled or when too many crossings were merged
+        if (handler->filled_count[ch] >= CHART_HANDLER_VALUES_COUNT ||
+            handler->acquisition_count[ch] >= CHART_HANDLER_EQUIVALENT_TIME_MAX_ACQUISITIONS)
+        {
+            // Stop the update if requested
+            if (handler->stop_request[ch]) {
+                handler->running[ch] = false;
+                handler->stop_request[ch] = false;
+
+                // Save current X scale and offset
+                handler->x_scale_paused[ch] = handler->x_scale[ch];
+                handler->x_offset_paused[ch] = handler->x_offset[ch];
+            }
+
+            // The crossings are already placed exactly on the trigger value
+            handler->trigger_index[ch] = (int32_t)pre;
+            handler->trigger_delay_count[ch] = 0U;
+            handler->trigger_fraction[ch] = 0.f;
+            handler->ready[ch] = true;
+            _chart_handler_reset_equivalent_time(handler, ch);
+            return;
+        }
+    }
+}
+
+/**
+ * @brief Decimate the record into the values of a stopped channel
+ *
+ * @details When the channel is stopped the last value is on the right edge of the chart,
+ * the record is then zoomed around the center of the chart and shifted by the time offset
+ *
+ * @param handler A pointer to the chart handler structure
+ * @param ch The channel to update
+ *
+ * @return bool True if the values were taken from the record, false if the record is not available
+ */
+static bool _chart_handler_read_record(ChartHandler * handler, ChartHandlerChannel ch) {
+    const float time_per_sample = record_get_time_per_sample();
+    if (handler->record_index[ch] < 0 || !record_is_frozen() || time_per_sample <= 0.f)
+        return false;
+
+    const float half = (float)(CHART_HANDLER_VALUES_COUNT / 2U);
+    const float samples_per_value = handler->x_scale[ch] / CHART_HANDLER_VALUES_PER_DIVISION / time_per_sample;
+    const float paused_samples_per_value = handler->x_scale_paused[ch] / CHART_HANDLER_VALUES_PER_DIVISION / time_per_sample;
+
+    // Index of the samples shown at the center of the chart and on the left edge
+    const float center = handler->record_index[ch] - (CHART_HANDLER_VALUES_COUNT - 1U - half) * paused_samples_per_value;
+    const float shift = (handler->x_offset[ch] - handler->x_offset_paused[ch]) / time_per_sample;
+    const float first = center - shift - half * samples_per_value;
+    const float last = first + (CHART_HANDLER_VALUES_COUNT - 1U) * samples_per_value;
+
+    // Only the displayed window is read
+    ChartHandlerBlock window[RECORD_WINDOW_BLOCK_COUNT];
+    size_t window_count = 0U;
+    size_t start = 0U;
+    size_t end = 0U;
+    if (last >= 0.f && first < (float)record_get_count()) {
+        start = first < 0.f ? 0U : (size_t)first;
+        end = last < (float)record_get_count() ? (size_t)last + 1U : record_get_count();
+        window_count = record_get_window(start, end - start, window);
+    }
+
+    const bool peak = handler->acquisition_mode == CHART_HANDLER_ACQUISITION_PEAK_DETECT;
+    const bool high_resolution = handler->acquisition_mode == CHART_HANDLER_ACQUISITION_HIGH_RESOLUTION;
+    for (size_t i = 0U; i < CHART_HANDLER_VALUES_COUNT; ++i) {
+        int16_t point = CHART_HANDLER_POINT_NONE;
+        int16_t point_min = CHART_HANDLER_POINT_NONE;
+
+        const float sample = first + i * samples_per_value;
+        if (sample >= (float)start && sample < (float)end) {
+            size_t j = (size_t)sample - start;
+            if (peak || high_resolution) {
+                // Every sample up to the next value is reduced to a single value
+                size_t n = (size_t)(sample + samples_per_value) - (size_t)sample;
+                if (n == 0U)
+                    n = 1U;
+                uint16_t min = UINT16_MAX;
+                uint16_t max = 0U;
+                uint64_t sum = 0U;
+                size_t count = 0U;
+                for (size_t b = 0U; b < window_count && n > 0U; ++b) {
+                    if (j < window[b].count) {
+                        const size_t len = window[b].count - j < n ? window[b].count - j : n;
+                        if (peak)
+                            _chart_handler_find_peaks(&window[b], ch, j, j + len, &min, &max);
+                        else
+                            _chart_handler_sum(&window[b], ch, j, j + len, &sum);
+                        count += len;
+                        n -= len;
+                        j = 0U;
+                    }
+                    else
+                        j -= window[b].count;
+                }
+                if (peak && count > 0U) {
+                    point = _chart_handler_to_chart(ch, max);
+                    point_min = _chart_handler_to_chart(ch, min);
+                }
+                else if (count > 0U)
+                    point = _chart_handler_to_chart(ch, (uint16_t)((sum + count / 2U) / count));
+            }
+            else {
+                for (size_t b = 0U; b < window_count; ++b) {
+                    if (j < window[b].count) {
+                        point = _chart_handler_to_chart(ch, window[b].raw[ch][j * window[b].stride]);
+                        break;
+                    }
+                    j -= window[b].count;
+                }
+            }
+        }
+
+        handler->data[ch][i] = point;
+        if (peak)
+            handler->data_min[ch][i] = point_min;
+    }
+    return true;
 }
 
 void chart_handler_init(ChartHandler * handler, void * api) {
@@ -70,9 +1187,24 @@ void chart_handler_init(ChartHandler * handler, void * api) {
         handler->scale[ch] = CHART_DEFAULT_Y_SCALE;
 
         handler->trigger[ch] = ADC_VOLTAGE_TO_VALUE(1000.f);
+        handler->trigger_second[ch] = ADC_VOLTAGE_TO_VALUE(2000.f);
         handler->trigger_index[ch] = -1;
+        _chart_handler_reset_trigger(handler, ch);
+        handler->record_index[ch] = -1;
+        _chart_handler_reset_peaks(handler, ch);
+        _chart_handler_update_lut(handler, ch);
     }
+    handler->acquisition_mode = CHART_HANDLER_ACQUISITION_NORMAL;
+    handler->trigger_mode = CHART_HANDLER_TRIGGER_AUTO;
+    handler->trigger_source = CHART_HANDLER_TRIGGER_SOURCE_CHANNEL_1;
+    handler->trigger_hysteresis = CHART_HANDLER_TRIGGER_DELTA;
+    handler->trigger_position = 50.f;
+    handler->trigger_type = CHART_HANDLER_TRIGGER_EDGE;
+    handler->trigger_condition = CHART_HANDLER_TRIGGER_LESS;
+    handler->trigger_limit_low = 0.1f;
+    handler->trigger_limit_high = 1.f;
     handler->knob_mode = CHART_HANDLER_KNOB_VOLTAGE;
+    chart_handler_set_average_count(handler, CHART_HANDLER_AVERAGE_DEFAULT_COUNT);
 }
 
 bool chart_handler_is_enabled(ChartHandler * handler, ChartHandlerChannel ch) {
@@ -89,6 +1221,9 @@ void chart_handler_set_enable(ChartHandler * handler, ChartHandlerChannel ch, bo
         chart_handler_invalidate(handler, ch);
     else
         lv_api_clear_channel_data(handler->api, ch);
+
+    // The sample rate depends on the enabled channels
+    acquisition_set_timebase(chart_handler_get_timebase(handler));
 }
 
 void chart_handler_toggle_enable(ChartHandler * handler, ChartHandlerChannel ch) {
@@ -110,6 +1245,9 @@ void chart_handler_set_trigger(
         return;
     handler->trigger[ch] = value;
     lv_api_update_trigger_line(handler->api, ch, ADC_VALUE_TO_VOLTAGE(value));
+
+    // The analog watchdogs must follow the trigger level
+    acquisition_update_trigger_level();
 }
 
 ChartHandlerKnobMode chart_handler_knob_get_mode(ChartHandler * handler) {
@@ -139,8 +1277,19 @@ void chart_handler_set_running(ChartHandler * handler, ChartHandlerChannel ch, b
 
     if (running) {
         handler->running[ch] = true;
+        handler->record_index[ch] = -1;
+        segments_reset(ch);
         chart_handler_invalidate(handler, ch);
 
+        // Start recording again once every channel is running
+        bool all_running = true;
+        for (size_t i = 0U; i < CHART_HANDLER_CHANNEL_COUNT; ++i)
+            all_running = all_running && handler->running[i];
+        if (all_running && record_is_frozen()) {
+            record_set_frozen(false);
+            acquisition_set_timebase(chart_handler_get_timebase(handler));
+        }
+
         lv_api_enable_trigger_checkbox(handler->api);
     }
     else {
@@ -167,6 +1316,232 @@ bool chart_handler_is_trigger_enabled(ChartHandler * handler) {
     return handler->ascending_trigger || handler->descending_trigger;
 }
 
+bool chart_handler_is_equivalent_time_enabled(ChartHandler * handler) {
+    if (handler == NULL)
+        return false;
+    return handler->equivalent_time;
+}
+
+void chart_handler_set_equivalent_time(ChartHandler * handler, bool enabled) {
+    if (handler == NULL)
+        return;
+    handler->equivalent_time = enabled;
+
+    // Go back to the minimum time scale that the ADC can sample in real time
+    bool update = false;
+    for (size_t ch = 0U; ch < CHART_HANDLER_CHANNEL_COUNT; ++ch) {
+        chart_handler_invalidate(handler, ch);
+        if (!enabled && handler->x_scale[ch] < CHART_MIN_X_SCALE) {
+            handler->x_scale_paused[ch] = handler->x_scale[ch] = CHART_MIN_X_SCALE;
+            update = true;
+        }
+    }
+    if (update) {
+        acquisition_set_timebase(chart_handler_get_timebase(handler));
+        lv_api_update_div_text(handler->api);
+    }
+}
+
+ChartHandlerAcquisitionMode chart_handler_get_acquisition_mode(ChartHandler * handler) {
+    if (handler == NULL)
+        return CHART_HANDLER_ACQUISITION_NORMAL;
+    return handler->acquisition_mode;
+}
+
+void chart_handler_set_acquisition_mode(ChartHandler * handler, ChartHandlerAcquisitionMode mode) {
+    if (handler == NULL || mode >= CHART_HANDLER_ACQUISITION_COUNT)
+        return;
+    handler->acquisition_mode = mode;
+
+    // The values taken with the previous mode are discarded
+    for (size_t ch = 0U; ch < CHART_HANDLER_CHANNEL_COUNT; ++ch)
+        chart_handler_invalidate(handler, ch);
+
+    // The sample rate depends on the mode too
+    acquisition_set_timebase(chart_handler_get_timebase(handler));
+}
+
+size_t chart_handler_get_average_count(ChartHandler * handler) {
+    if (handler == NULL)
+        return CHART_HANDLER_AVERAGE_DEFAULT_COUNT;
+    return 1U << handler->average_shift;
+}
+
+void chart_handler_set_average_count(ChartHandler * handler, size_t count) {
+    if (handler == NULL) return;
+    if (count < CHART_HANDLER_AVERAGE_MIN_COUNT || count > CHART_HANDLER_AVERAGE_MAX_COUNT) return;
+    if ((count & (count - 1U)) != 0U) return;
+
+    uint32_t shift = 0U;
+    while ((1U << shift) < count)
+        ++shift;
+    handler->average_shift = shift;
+
+    // Start a new average
+    for (size_t ch = 0U; ch < CHART_HANDLER_CHANNEL_COUNT; ++ch)
+        chart_handler_invalidate(handler, ch);
+}
+
+ChartHandlerTriggerMode chart_handler_get_trigger_mode(ChartHandler * handler) {
+    if (handler == NULL)
+        return CHART_HANDLER_TRIGGER_AUTO;
+    return handler->trigger_mode;
+}
+
+void chart_handler_set_trigger_mode(ChartHandler * handler, ChartHandlerTriggerMode mode) {
+    if (handler == NULL || mode >= CHART_HANDLER_TRIGGER_COUNT)
+        return;
+    handler->trigger_mode = mode;
+    for (size_t ch = 0U; ch < CHART_HANDLER_CHANNEL_COUNT; ++ch)
+        chart_handler_invalidate(handler, ch);
+}
+
+size_t chart_handler_get_segment_view(ChartHandler * handler) {
+    if (handler == NULL)
+        return 0U;
+    return handler->segment_view;
+}
+
+void chart_handler_set_segment_view(ChartHandler * handler, size_t view) {
+    if (handler == NULL)
+        return;
+    handler->segment_view = view;
+    for (size_t ch = 0U; ch < CHART_HANDLER_CHANNEL_COUNT; ++ch)
+        handler->segment_update[ch] = true;
+}
+
+ChartHandlerTriggerSource chart_handler_get_trigger_source(ChartHandler * handler) {
+    if (handler == NULL)
+        return CHART_HANDLER_TRIGGER_SOURCE_CHANNEL_1;
+    return handler->trigger_source;
+}
+
+void chart_handler_set_trigger_source(ChartHandler * handler, ChartHandlerTriggerSource source) {
+    if (handler == NULL || source >= CHART_HANDLER_TRIGGER_SOURCE_COUNT)
+        return;
+    handler->trigger_source = source;
+    for (size_t ch = 0U; ch < CHART_HANDLER_CHANNEL_COUNT; ++ch)
+        chart_handler_invalidate(handler, ch);
+}
+
+ChartHandlerChannel chart_handler_get_trigger_channel(ChartHandler * handler) {
+    if (handler == NULL)
+        return CHART_HANDLER_CHANNEL_1;
+    switch (handler->trigger_source) {
+        case CHART_HANDLER_TRIGGER_SOURCE_CHANNEL_1:
+            return CHART_HANDLER_CHANNEL_1;
+        case CHART_HANDLER_TRIGGER_SOURCE_CHANNEL_2:
+            return CHART_HANDLER_CHANNEL_2;
+        default:
+            return CHART_HANDLER_CHANNEL_COUNT;
+    }
+}
+
+float chart_handler_get_trigger_holdoff(ChartHandler * handler) {
+    if (handler == NULL)
+        return 0.f;
+    return handler->trigger_holdoff;
+}
+
+void chart_handler_set_trigger_holdoff(ChartHandler * handler, float holdoff) {
+    if (handler == NULL || holdoff < 0.f)
+        return;
+    handler->trigger_holdoff = holdoff;
+    for (size_t ch = 0U; ch < CHART_HANDLER_CHANNEL_COUNT; ++ch)
+        handler->trigger_holdoff_left[ch] = 0.f;
+}
+
+uint16_t chart_handler_get_trigger_hysteresis(ChartHandler * handler) {
+    if (handler == NULL)
+        return CHART_HANDLER_TRIGGER_DELTA;
+    return handler->trigger_hysteresis;
+}
+
+void chart_handler_set_trigger_hysteresis(ChartHandler * handler, uint16_t hysteresis) {
+    if (handler == NULL)
+        return;
+    handler->trigger_hysteresis = hysteresis;
+    for (size_t ch = 0U; ch < CHART_HANDLER_CHANNEL_COUNT; ++ch)
+        handler->trigger_armed[ch] = false;
+}
+
+float chart_handler_get_trigger_position(ChartHandler * handler) {
+    if (handler == NULL)
+        return 50.f;
+    return handler->trigger_position;
+}
+
+void chart_handler_set_trigger_position(ChartHandler * handler, float position) {
+    if (handler == NULL || position < 0.f || position > 100.f)
+        return;
+    handler->trigger_position = position;
+    for (size_t ch = 0U; ch < CHART_HANDLER_CHANNEL_COUNT; ++ch)
+        chart_handler_invalidate(handler, ch);
+}
+
+float chart_handler_get_trigger_delay(ChartHandler * handler) {
+    if (handler == NULL)
+        return 0.f;
+    return handler->trigger_delay;
+}
+
+void chart_handler_set_trigger_delay(ChartHandler * handler, float delay) {
+    if (handler == NULL || delay < 0.f)
+        return;
+    handler->trigger_delay = delay;
+    for (size_t ch = 0U; ch < CHART_HANDLER_CHANNEL_COUNT; ++ch)
+        chart_handler_invalidate(handler, ch);
+}
+
+ChartHandlerTriggerType chart_handler_get_trigger_type(ChartHandler * handler) {
+    if (handler == NULL)
+        return CHART_HANDLER_TRIGGER_EDGE;
+    return handler->trigger_type;
+}
+
+void chart_handler_set_trigger_type(ChartHandler * handler, ChartHandlerTriggerType type) {
+    if (handler == NULL || type >= CHART_HANDLER_TRIGGER_TYPE_COUNT)
+        return;
+    handler->trigger_type = type;
+    for (size_t ch = 0U; ch < CHART_HANDLER_CHANNEL_COUNT; ++ch)
+        chart_handler_invalidate(handler, ch);
+}
+
+ChartHandlerTriggerCondition chart_handler_get_trigger_condition(ChartHandler * handler) {
+    if (handler == NULL)
+        return CHART_HANDLER_TRIGGER_LESS;
+    return handler->trigger_condition;
+}
+
+void chart_handler_set_trigger_condition(ChartHandler * handler, ChartHandlerTriggerCondition condition) {
+    if (handler == NULL || condition >= CHART_HANDLER_TRIGGER_CONDITION_COUNT)
+        return;
+    handler->trigger_condition = condition;
+}
+
+void chart_handler_set_trigger_limits(ChartHandler * handler, float low, float high) {
+    if (handler == NULL || low < 0.f || high < low)
+        return;
+    handler->trigger_limit_low = low;
+    handler->trigger_limit_high = high;
+}
+
+uint16_t chart_handler_get_trigger_second(ChartHandler * handler, ChartHandlerChannel ch) {
+    if (handler == NULL)
+        return 0U;
+    return handler->trigger_second[ch];
+}
+
+HAL_StatusTypeDef chart_handler_set_trigger_second(ChartHandler * handler, ChartHandlerChannel ch, uint16_t value) {
+    if (handler == NULL || ch >= CHART_HANDLER_CHANNEL_COUNT)
+        return HAL_ERROR;
+    if (!_chart_handler_is_trigger_second_valid(handler, ch, value))
+        return HAL_ERROR;
+    handler->trigger_second[ch] = value;
+    handler->trigger_armed[ch] = false;
+    return HAL_OK;
+}
+
 float chart_handler_get_offset(ChartHandler * handler, ChartHandlerChannel ch) {
     if (handler == NULL)
         return 0;
@@ -179,6 +1554,7 @@ void chart_handler_set_offset(ChartHandler * handler, ChartHandlerChannel ch, fl
 
     // Update offset and invalidate old data
     handler->offset[ch] = value;
+    _chart_handler_update_lut(handler, ch);
     chart_handler_invalidate(handler, ch);
 }
 
@@ -195,14 +1571,15 @@ void chart_handler_set_scale(ChartHandler * handler, ChartHandlerChannel ch, flo
 
     // Update scale and invalidate old data
     handler->scale[ch] = value;
+    _chart_handler_update_lut(handler, ch);
     chart_handler_invalidate(handler, ch);
 
     // Notify LVGL
     lv_api_update_div_text(handler->api);
-    if (chart_handler_is_trigger_enabled(handler)) {
+    if (chart_handler_is_trigger_enabled(handler) && ch == chart_handler_get_trigger_channel(handler)) {
         lv_api_update_trigger_line(
             handler->api,
-            CHART_HANDLER_CHANNEL_1,
+            ch,
             ADC_VALUE_TO_VOLTAGE(handler->trigger[ch])
         );
     }
@@ -217,13 +1594,18 @@ float chart_handler_get_x_scale(ChartHandler * handler, ChartHandlerChannel ch)
 void chart_handler_set_x_scale(ChartHandler * handler, ChartHandlerChannel ch, float value) {
     if (handler == NULL) return;
     if (!handler->enabled[ch]) return;
-    if (!chart_handler_is_running(handler, ch) && chart_handler_is_trigger_enabled(handler)) return;
-    if (value > CHART_MAX_X_SCALE || value < CHART_MIN_X_SCALE) return;
+    if (!chart_handler_is_running(handler, ch) && chart_handler_is_trigger_enabled(handler) && handler->record_index[ch] < 0) return;
+    if (value > CHART_MAX_X_SCALE) return;
+    if (value < (handler->equivalent_time ? CHART_EQUIVALENT_TIME_MIN_X_SCALE : CHART_MIN_X_SCALE)) return;
 
     // Update scale and invalidate old data
     handler->x_scale[ch] = value;
     chart_handler_invalidate(handler, ch);
 
+    // Update the ADC sample rate, unless the frozen record is being zoomed
+    if (!record_is_frozen())
+        acquisition_set_timebase(chart_handler_get_timebase(handler));
+
     // Notify LVGL
     lv_api_update_div_text(handler->api);
 }
@@ -243,46 +1625,99 @@ void chart_handler_set_x_offset(ChartHandler * handler, ChartHandlerChannel ch,
     chart_handler_invalidate(handler, ch);
 }
 
+float chart_handler_get_timebase(ChartHandler * handler) {
+    if (handler == NULL)
+        return CHART_DEFAULT_X_SCALE;
+
+    float x_scale = CHART_MAX_X_SCALE;
+    for (size_t ch = 0U; ch < CHART_HANDLER_CHANNEL_COUNT; ++ch) {
+        if (handler->enabled[ch] && handler->x_scale[ch] < x_scale)
+            x_scale = handler->x_scale[ch];
+    }
+    return x_scale;
+}
+
 float chart_handler_voltage_to_grid_units(ChartHandler * handler, ChartHandlerChannel ch, float value) {
     if (handler == NULL)
         return 0.f;
     return value / handler->scale[ch];
 }
 
-// TODO: Add horizontal offset
-void chart_handler_update(ChartHandler * handler, uint32_t t) {
-    if (handler == NULL)
+void chart_handler_update(ChartHandler * handler, const ChartHandlerBlock * block) {
+    if (handler == NULL || block == NULL || block->count == 0U)
         return;
 
-    volatile const uint16_t * raw[] = {
-        (uint16_t *)CHART_CH1_RAW_DATA_ADDRESS,
-        (uint16_t *)CHART_CH2_RAW_DATA_ADDRESS
-    };
-    
     // Get time for each sample in us
-    const float time_per_sample = t / (float)CHART_SAMPLE_COUNT;
+    const float time_per_sample = block->time_per_sample;
+
+    // Offset of the next value from the start of the block (the blocks are contiguous)
+    static float off[CHART_HANDLER_CHANNEL_COUNT] = { 0.f };
+
+    // The block is the last one inside the record only if it was not frozen before
+    const bool recorded = !record_is_frozen() && record_get_count() >= block->count;
+
+    // Every triggered frame is saved into its own segment
+    const bool segmented = segments_is_enabled() && chart_handler_is_trigger_enabled(handler);
 
     for (size_t ch = 0U; ch < CHART_HANDLER_CHANNEL_COUNT; ++ch) {
         if (!handler->enabled[ch] || !handler->running[ch] || handler->ready[ch])
             continue;
 
+        // Merge many acquisitions when the ADC is too slow for the time scale
+        if (_chart_handler_is_equivalent_time(handler, ch, time_per_sample)) {
+            _chart_handler_update_equivalent_time(handler, ch, block);
+            continue;
+        }
+
         // Time between each value in us
         const float time_per_value = handler->x_scale[ch] / CHART_HANDLER_VALUES_PER_DIVISION;
         // Number of values for each sample
         const float samples_per_value = time_per_value / time_per_sample;
 
-        static uint16_t prev_raw = 0U;
+        // Index of the first sample not yet included in the peaks or in the sum
+        const bool peak = handler->acquisition_mode == CHART_HANDLER_ACQUISITION_PEAK_DETECT;
+        const bool high_resolution = handler->acquisition_mode == CHART_HANDLER_ACQUISITION_HIGH_RESOLUTION;
+        size_t start = 0U;
 
-        volatile static float off = 0.f; 
-        for (size_t i = 0U; i < CHART_HANDLER_VALUES_COUNT; ++i) {
+        // Index of the first sample not yet searched for a trigger event
+        size_t scan = 0U;
+        bool searchable = _chart_handler_block_can_trigger(handler, ch, block);
+
+        // The auto mode waits at least the time needed to fill the chart
+        const float auto_timeout = fmaxf(CHART_HANDLER_TRIGGER_AUTO_TIMEOUT, time_per_value * CHART_HANDLER_VALUES_COUNT);
+
+        // The values before the trigger that are pushed out of the ring by the delay are not needed
+        const size_t pre = _chart_handler_pre_trigger_count(handler);
+        const size_t delay = _chart_handler_delay_count(handler, ch);
+        const size_t before_needed = pre > delay ? pre - delay : 0U;
+        const size_t after_needed = CHART_HANDLER_VALUES_COUNT - pre + delay;
+        const size_t total_needed = before_needed + after_needed;
+
+        // A single block can contain more values than the ones displayed
+        for (size_t i = 0U; ; ++i) {
             // Calculate samples index
-            float samples = samples_per_value * i + off;
+            float samples = samples_per_value * i + off[ch];
             size_t j = samples < 0.f ? 0U : (size_t)floorf(samples);
 
             // Break if more samples are needed
-            if (j >= CHART_SAMPLE_COUNT) {
-                // Calculate offset
-                off = (samples + 1.f) - (float)CHART_SAMPLE_COUNT;
+            if (j >= block->count) {
+                // Calculate offset from the start of the next block
+                off[ch] = samples - (float)block->count;
+
+                // The remaining samples belong to the next value
+                if (peak)
+                    _chart_handler_find_peaks(block, ch, start, block->count, &handler->peak_min[ch], &handler->peak_max[ch]);
+                else if (high_resolution && start < block->count) {
+                    _chart_handler_sum(block, ch, start, block->count, &handler->high_resolution_sum[ch]);
+                    handler->high_resolution_count[ch] += block->count - start;
+                }
+
+                // An event after the last value belongs to the next one
+                if (searchable && handler->trigger_state[ch] == CHART_HANDLER_TRIGGER_STATE_ARMED && !handler->trigger_pending[ch]) {
+                    handler->trigger_pending[ch] = _chart_handler_search_trigger(handler, ch, block, scan, block->count);
+                    if (handler->trigger_pending[ch])
+                        handler->trigger_crossing[ch] -= (float)block->count;
+                }
 
                 // Update loading bar
                 if (!chart_handler_is_trigger_enabled(handler) && handler->x_scale[ch] >= CHART_LOADING_BAR_THRESHOLD)
@@ -291,46 +1726,115 @@ void chart_handler_update(ChartHandler * handler, uint32_t t) {
             }
 
             // Copy value
-            uint16_t value = raw[ch][j];
+            uint16_t value = block->raw[ch][j * block->stride];
             handler->raw[ch][handler->index[ch]] = value;
 
-            // Trigger
-            // TODO: Add horizontal offset
-            if (chart_handler_is_trigger_enabled(handler)) {
-                // Wait until there are enough samples before the trigger
-                if (handler->trigger_before_count[ch] < CHART_HANDLER_VALUES_COUNT / 2U) {
-                    ++handler->trigger_before_count[ch];
-                    if (handler->x_scale[ch] >= CHART_LOADING_BAR_THRESHOLD)
-                        lv_api_update_loading_bar(handler->api, handler->trigger_before_count[CHART_HANDLER_CHANNEL_1]);
+            // Keep the span of all the samples taken since the previous value
+            if (peak) {
+                if (j >= start) {
+                    _chart_handler_find_peaks(block, ch, start, j + 1U, &handler->peak_min[ch], &handler->peak_max[ch]);
+                    start = j + 1U;
+                }
+                handler->raw_min[ch][handler->index[ch]] = handler->peak_min[ch] < value ? handler->peak_min[ch] : value;
+                handler->raw_max[ch][handler->index[ch]] = handler->peak_max[ch] > value ? handler->peak_max[ch] : value;
+                _chart_handler_reset_peaks(handler, ch);
+            }
+            else if (high_resolution) {
+                if (j >= start) {
+                    _chart_handler_sum(block, ch, start, j + 1U, &handler->high_resolution_sum[ch]);
+                    handler->high_resolution_count[ch] += j + 1U - start;
+                    start = j + 1U;
                 }
-                else {
-                    bool asc = handler->ascending_trigger && _chart_handler_is_rising_edge(prev_raw, value, handler->trigger[ch]);
-                    bool desc = handler->descending_trigger && _chart_handler_is_falling_edge(prev_raw, value, handler->trigger[ch]);
 
-                    // Check if signal has crossed the trigger
-                    if (handler->trigger_index[ch] < 0 && (asc || desc))
-                        handler->trigger_index[ch] = handler->index[ch];
+                // The mean replaces the sample, the trigger is still compared with the sample
+                const size_t count = handler->high_resolution_count[ch];
+                if (count > 0U)
+                    handler->raw[ch][handler->index[ch]] = (uint16_t)((handler->high_resolution_sum[ch] + count / 2U) / count);
+                _chart_handler_reset_peaks(handler, ch);
+            }
 
-                    if (handler->trigger_index[ch] >= 0) {
+            // Trigger
+            if (chart_handler_is_trigger_enabled(handler)) {
+                switch (handler->trigger_state[ch]) {
+                    case CHART_HANDLER_TRIGGER_STATE_PRE_TRIGGER:
+                        // Wait until there are enough values before the trigger
+                        if (handler->trigger_before_count[ch] < before_needed) {
+                            ++handler->trigger_before_count[ch];
+                            if (handler->x_scale[ch] >= CHART_LOADING_BAR_THRESHOLD)
+                                lv_api_update_loading_bar(
+                                    handler->api,
+                                    handler->trigger_before_count[CHART_HANDLER_CHANNEL_1] * CHART_HANDLER_VALUES_COUNT / total_needed
+                                );
+                            if (handler->trigger_before_count[ch] < before_needed)
+                                break;
+                        }
+                        handler->trigger_state[ch] = CHART_HANDLER_TRIGGER_STATE_ARMED;
+                        scan = j + 1U;
+                        break;
+                    case CHART_HANDLER_TRIGGER_STATE_ARMED:
+                        // Search all the samples taken since the previous value
+                        if (searchable && !handler->trigger_pending[ch] && j >= scan)
+                            handler->trigger_pending[ch] = _chart_handler_search_trigger(handler, ch, block, scan, j + 1U);
+                        scan = j + 1U;
+
+                        // In auto mode the signal is displayed anyway after the timeout
+                        handler->trigger_wait[ch] += time_per_value;
+                        if (!handler->trigger_pending[ch] &&
+                            (handler->trigger_mode != CHART_HANDLER_TRIGGER_AUTO || handler->trigger_wait[ch] < auto_timeout))
+                            break;
+
+                        // Distance between the crossing and the trigger value, 0 when the trigger is forced
+                        handler->trigger_fraction[ch] = 0.f;
+                        handler->trigger_time[ch] = block->time + j * (double)time_per_sample;
+                        handler->trigger_forced[ch] = !handler->trigger_pending[ch];
+                        if (handler->trigger_pending[ch]) {
+                            const float fraction = ((float)j - handler->trigger_crossing[ch]) / samples_per_value;
+                            handler->trigger_fraction[ch] = fraction < 0.f ? 0.f : (fraction > 1.f ? 1.f : fraction);
+                            handler->trigger_time[ch] = block->time + handler->trigger_crossing[ch] * (double)time_per_sample;
+                        }
+                        handler->trigger_pending[ch] = false;
+                        handler->trigger_index[ch] = handler->index[ch];
+                        handler->trigger_delay_count[ch] = delay;
+                        handler->trigger_state[ch] = CHART_HANDLER_TRIGGER_STATE_TRIGGERED;
+                        // fall through
+                    case CHART_HANDLER_TRIGGER_STATE_TRIGGERED:
                         ++handler->trigger_after_count[ch];
                         if (handler->x_scale[ch] >= CHART_LOADING_BAR_THRESHOLD)
                             lv_api_update_loading_bar(
                                 handler->api,
-                                handler->trigger_before_count[CHART_HANDLER_CHANNEL_1] +
-                                handler->trigger_after_count[CHART_HANDLER_CHANNEL_1]
+                                (handler->trigger_before_count[CHART_HANDLER_CHANNEL_1] +
+                                handler->trigger_after_count[CHART_HANDLER_CHANNEL_1]) * CHART_HANDLER_VALUES_COUNT / total_needed
                             );
-                    }
+                        break;
                 }
-                prev_raw = value;
             }
             ++handler->index[ch];
 
 
             // Check if the signal is ready to be displayed
-            if (_chart_handler_is_data_ready(handler, handler->trigger_after_count[ch], handler->index[ch])) {
+            if (_chart_handler_is_data_ready(handler, ch, after_needed)) {
+                // Save the segment and search the next event from the next value,
+                // the frames forced by the auto mode timeout are only displayed
+                if (segmented && !handler->trigger_forced[ch]) {
+                    _chart_handler_save_segment(handler, ch);
+                    if (!segments_is_full(ch) && !handler->stop_request[ch]) {
+                        _chart_handler_rearm_trigger(handler, ch, before_needed);
+                        scan = j + 1U;
+                        searchable = _chart_handler_block_can_trigger(handler, ch, block);
+                        handler->index[ch] %= CHART_HANDLER_VALUES_COUNT;
+                        continue;
+                    }
+                    handler->stop_request[ch] = true;
+                    handler->segment_update[ch] = true;
+                }
+
                 // Hide loading bar when data is ready
                 lv_api_hide_loading_bar(handler->api);
 
+                // A single acquisition stops after the first frame
+                if (chart_handler_is_trigger_enabled(handler) && handler->trigger_mode == CHART_HANDLER_TRIGGER_SINGLE)
+                    handler->stop_request[ch] = true;
+
                 // Stop the update if requested
                 if (handler->stop_request[ch]) {
                     handler->running[ch] = false;
@@ -339,13 +1843,18 @@ void chart_handler_update(ChartHandler * handler, uint32_t t) {
                     // Save current X scale and offset
                     handler->x_scale_paused[ch] = handler->x_scale[ch];
                     handler->x_offset_paused[ch] = handler->x_offset[ch];
+
+                    // Keep the recorded samples to zoom into the stopped signal
+                    if (recorded) {
+                        handler->record_index[ch] = (int32_t)(record_get_count() - block->count + j);
+                        record_set_frozen(true);
+                    }
                 }
 
-                handler->trigger_before_count[ch] = 0U;
-                handler->trigger_after_count[ch] = 0U;
-                prev_raw = 0U;
-                
-                off = 0.f;
+                _chart_handler_reset_trigger(handler, ch);
+                _chart_handler_reset_peaks(handler, ch);
+
+                off[ch] = 0.f;
                 handler->index[ch] = 0U;
                 handler->ready[ch] = true;
                 break;
@@ -353,6 +1862,14 @@ void chart_handler_update(ChartHandler * handler, uint32_t t) {
             handler->index[ch] %= CHART_HANDLER_VALUES_COUNT;
         }
     }
+
+    // The holdoff time left and the start of the pulses are counted from the start of the next block
+    for (size_t ch = 0U; ch < CHART_HANDLER_CHANNEL_COUNT; ++ch) {
+        handler->trigger_holdoff_left[ch] -= block->count * time_per_sample;
+        if (handler->trigger_holdoff_left[ch] < 0.f)
+            handler->trigger_holdoff_left[ch] = 0.f;
+        handler->trigger_start[ch] -= (int64_t)block->count;
+    }
 }
 
 void chart_handler_routine(ChartHandler * handler) {
@@ -364,6 +1881,26 @@ void chart_handler_routine(ChartHandler * handler) {
         if (!handler->enabled[ch] || (handler->running[ch] && !handler->ready[ch]))
             continue;
 
+        // The maximum values are displayed as the main ones in peak detect mode
+        const bool peak = handler->acquisition_mode == CHART_HANDLER_ACQUISITION_PEAK_DETECT;
+        const uint16_t * raw = peak ? handler->raw_max[ch] : handler->raw[ch];
+        const int16_t * data_min = peak ? handler->data_min[ch] : NULL;
+
+        // The saved segments are displayed once the channel stops
+        if (!handler->running[ch] && segments_get_count(ch) > 0U) {
+            if (handler->segment_update[ch] || handler->ready[ch])
+                _chart_handler_show_segments(handler, ch);
+            handler->segment_update[ch] = false;
+            handler->ready[ch] = false;
+            continue;
+        }
+
+        // A stopped channel is taken again from the record at the current time scale and offset
+        if (!handler->running[ch] && _chart_handler_read_record(handler, ch)) {
+            lv_api_update_points(handler->api, ch, handler->data[ch], data_min, CHART_HANDLER_VALUES_COUNT);
+            continue;
+        }
+
         const float x_scale_ratio = handler->x_scale[ch] / handler->x_scale_paused[ch];
 
         const float time_per_value = handler->x_scale[ch] / CHART_HANDLER_VALUES_PER_DIVISION;
@@ -373,14 +1910,32 @@ void chart_handler_routine(ChartHandler * handler) {
         const size_t half = CHART_HANDLER_VALUES_COUNT / 2U;
 
         // Shift index based on trigger if enabled
-        size_t index = 0;
-        if (chart_handler_is_trigger_enabled(handler)) {
-            const size_t trigger_offset = half;
-            index = (trigger_offset - handler->trigger_index[ch] + CHART_HANDLER_VALUES_COUNT) % CHART_HANDLER_VALUES_COUNT;
+        size_t index = _chart_handler_display_index(handler, ch);
+
+        // Place the crossing of a new frame exactly at the trigger position
+        if (chart_handler_is_trigger_enabled(handler) && handler->ready[ch])
+            _chart_handler_align_trigger(handler, ch, index);
+
+        // Replace a new frame with its average with the previous ones
+        if (handler->acquisition_mode == CHART_HANDLER_ACQUISITION_AVERAGE && handler->ready[ch]) {
+            // The weight of the new frame is halved every time the number of averaged frames doubles,
+            // so the first frames are displayed right away without waiting for the whole batch
+            if (handler->average_frames[ch] < CHART_HANDLER_AVERAGE_MAX_COUNT)
+                ++handler->average_frames[ch];
+            uint32_t shift = 0U;
+            while (shift < handler->average_shift && (2U << shift) <= handler->average_frames[ch])
+                ++shift;
+
+            // The accumulators are in display order so that the frames are aligned on the trigger
+            for (size_t i = 0U; i < CHART_HANDLER_VALUES_COUNT; ++i) {
+                const size_t k = (index + i) % CHART_HANDLER_VALUES_COUNT;
+                handler->raw[ch][i] = _chart_handler_average(&handler->average[ch][k], handler->raw[ch][i], shift);
+            }
         }
         
         for (volatile size_t i = 0; i < CHART_HANDLER_VALUES_COUNT; ++i) {
-            float val = NAN;
+            int16_t point = CHART_HANDLER_POINT_NONE;
+            int16_t point_min = CHART_HANDLER_POINT_NONE;
  
             if (!chart_handler_is_running(handler, ch)) {
                 // Do not update the values if the oscilloscope is stopped
@@ -406,31 +1961,30 @@ void chart_handler_routine(ChartHandler * handler) {
                 else
                     j -= half * ((int)x_scale_ratio - 1);
 
-                if (j >= 0 && j < CHART_HANDLER_VALUES_COUNT)
-                    val = ADC_VALUE_TO_VOLTAGE(handler->raw[ch][j]);
+                if (j >= 0 && j < CHART_HANDLER_VALUES_COUNT) {
+                    point = _chart_handler_to_chart(ch, raw[j]);
+                    point_min = _chart_handler_to_chart(ch, handler->raw_min[ch][j]);
+                }
+            }
+            else {
+                point = _chart_handler_to_chart(ch, raw[i]);
+                point_min = _chart_handler_to_chart(ch, handler->raw_min[ch][i]);
             }
-            else
-                val = ADC_VALUE_TO_VOLTAGE(handler->raw[ch][i]);
-
-            // Translate
-            val += handler->offset[ch];
-
-            // Convert to grid units
-            val = chart_handler_voltage_to_grid_units(handler, ch, val);
 
             // Copy data
-            handler->data[ch][index] = val;
+            handler->data[ch][index] = point;
+            if (peak)
+                handler->data_min[ch][index] = point_min;
             
             // Update index
             ++index;
             index %= CHART_HANDLER_VALUES_COUNT;
         }
 
-        lv_api_update_points(handler->api, ch, handler->data[ch], CHART_HANDLER_VALUES_COUNT);
+        lv_api_update_points(handler->api, ch, handler->data[ch], data_min, CHART_HANDLER_VALUES_COUNT);
         if (handler->running[ch])
             handler->trigger_index[ch] = -1;
-        handler->trigger_before_count[ch] = 0U;
-        handler->trigger_after_count[ch] = 0U;
+        _chart_handler_reset_trigger(handler, ch);
         handler->ready[ch] = false;
     }
 }
@@ -443,9 +1997,13 @@ void chart_handler_invalidate(ChartHandler * handler, ChartHandlerChannel ch) {
     handler->index[ch] = 0U;
     if (handler->running[ch])
         handler->trigger_index[ch] = -1;
-    handler->trigger_before_count[ch] = 0;
-    handler->trigger_after_count[ch] = 0;
+    _chart_handler_reset_trigger(handler, ch);
+    handler->trigger_holdoff_left[ch] = 0.f;
     handler->ready[ch] = false;
+    handler->segment_update[ch] = true;
+    _chart_handler_reset_equivalent_time(handler, ch);
+    _chart_handler_reset_peaks(handler, ch);
+    handler->average_frames[ch] = 0U;
 
     lv_api_hide_loading_bar(handler->api);
 }
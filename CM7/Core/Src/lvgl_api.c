@@ -14,23 +14,93 @@
 #include <string.h>
 #include <stdarg.h>
 
+#include "acquisition.h"
 #include "chart_handler.h"
 #include "config.h"
 #include "lvgl.h"
 #include "lvgl_colors.h"
+#include "lvgl_dma2d.h"
+#include "persistence.h"
+#include "record.h"
+#include "segments.h"
+#include "shared.h"
 #include "stm32h7xx_hal_ltdc.h"
+#include "waveform.h"
 
-#define LERP(A, B, T) ((A) * (1.0 - T) + (B) * (T))
+// Selectable record lengths in samples, in the same order of the dropdown options
+static const size_t record_lengths[] = { 0U, 64U * 1024U, 256U * 1024U, 1024U * 1024U, 4U * 1024U * 1024U };
+#define LV_API_RECORD_LENGTH_OPTIONS "Off\n64K\n256K\n1M\n4M"
+#define LV_API_RECORD_LENGTH_COUNT (sizeof(record_lengths) / sizeof(record_lengths[0]))
+
+// Selectable persistence decay times in ms, in the same order of the dropdown options
+static const uint32_t persistence_times[] = { 0U, 100U, 500U, 1000U, 5000U, PERSISTENCE_INFINITE };
+#define LV_API_PERSISTENCE_OPTIONS "Off\n100 ms\n500 ms\n1 s\n5 s\nInfinite"
+#define LV_API_PERSISTENCE_COUNT (sizeof(persistence_times) / sizeof(persistence_times[0]))
+
+// Selectable number of segments, in the same order of the dropdown options
+static const size_t segment_lengths[] = { 0U, 10U, 100U, 1000U };
+#define LV_API_SEGMENTS_OPTIONS "Off\n10\n100\n1000"
+#define LV_API_SEGMENTS_COUNT (sizeof(segment_lengths) / sizeof(segment_lengths[0]))
+
+// Size of the text of the segment label
+#define LV_API_SEGMENT_LABEL_SIZE (64U)
+
+// Trigger modes in the same order of ChartHandlerTriggerMode
+#define LV_API_TRIGGER_MODE_OPTIONS "Auto\nNormal\nSingle"
+
+// Trigger sources in the same order of ChartHandlerTriggerSource
+#define LV_API_TRIGGER_SOURCE_OPTIONS "CH1\nCH2\nExternal\nGenerator"
+
+// Selectable trigger holdoff times in us, in the same order of the dropdown options
+static const float holdoff_times[] = { 0.f, 10.f, 100.f, 1000.f, 10000.f, 100000.f };
+#define LV_API_HOLDOFF_OPTIONS "Off\n10 us\n100 us\n1 ms\n10 ms\n100 ms"
+#define LV_API_HOLDOFF_COUNT (sizeof(holdoff_times) / sizeof(holdoff_times[0]))
+
+// Selectable trigger positions in % of the chart width, in the same order of the dropdown options
+static const float trigger_positions[] = { 0.f, 10.f, 25.f, 50.f, 75.f, 90.f, 100.f };
+#define LV_API_TRIGGER_POSITION_OPTIONS "0 %\n10 %\n25 %\n50 %\n75 %\n90 %\n100 %"
+#define LV_API_TRIGGER_POSITION_COUNT (sizeof(trigger_positions) / sizeof(trigger_positions[0]))
+
+// Selectable delays after the trigger in us, in the same order of the dropdown options
+static const float trigger_delays[] = { 0.f, 10.f, 100.f, 1000.f, 10000.f, 100000.f, 1000000.f };
+#define LV_API_TRIGGER_DELAY_OPTIONS "Off\n10 us\n100 us\n1 ms\n10 ms\n100 ms\n1 s"
+#define LV_API_TRIGGER_DELAY_COUNT (sizeof(trigger_delays) / sizeof(trigger_delays[0]))
+
+// Selectable trigger hysteresis in mV, in the same order of the dropdown options
+static const float trigger_hysteresis[] = { 0.f, 10.f, 20.f, 50.f, 100.f, 200.f };
+#define LV_API_TRIGGER_HYSTERESIS_OPTIONS "Off\n10 mV\n20 mV\n50 mV\n100 mV\n200 mV"
+#define LV_API_TRIGGER_HYSTERESIS_COUNT (sizeof(trigger_hysteresis) / sizeof(trigger_hysteresis[0]))
+
+// Trigger types and time conditions in the same order of ChartHandlerTriggerType and ChartHandlerTriggerCondition
+#define LV_API_TRIGGER_TYPE_OPTIONS "Edge\nPulse width\nGlitch\nRunt\nSlope"
+#define LV_API_TRIGGER_CONDITION_OPTIONS "Less than\nGreater than\nIn range"
+
+// Selectable time limits of the trigger in divisions, in the same order of the dropdown options
+static const float trigger_limits[] = { 0.05f, 0.1f, 0.2f, 0.5f, 1.f, 2.f, 5.f };
+#define LV_API_TRIGGER_LIMIT_OPTIONS "0.05 div\n0.1 div\n0.2 div\n0.5 div\n1 div\n2 div\n5 div"
+#define LV_API_TRIGGER_LIMIT_COUNT (sizeof(trigger_limits) / sizeof(trigger_limits[0]))
+
+// Selectable second levels of the runt and slope triggers in mV, in the same order of the dropdown options
+static const float trigger_seconds[] = { 500.f, 1000.f, 1500.f, 2000.f, 2500.f, 3000.f };
+#define LV_API_TRIGGER_SECOND_OPTIONS "0.5 V\n1 V\n1.5 V\n2 V\n2.5 V\n3 V"
+#define LV_API_TRIGGER_SECOND_COUNT (sizeof(trigger_seconds) / sizeof(trigger_seconds[0]))
+
+// Acquisition modes in the same order of ChartHandlerAcquisitionMode
+#define LV_API_ACQUISITION_MODE_OPTIONS "Normal\nPeak detect\nAverage\nHi-Res"
+
+// Selectable number of averaged frames, each option doubles the previous one
+#define LV_API_AVERAGE_COUNT_OPTIONS "2\n4\n8\n16\n32\n64\n128\n256"
+
+// Conversion pacing in the same order of AcquisitionPacing
+#define LV_API_PACING_OPTIONS "Timer\nFree running"
 
 extern LTDC_HandleTypeDef hltdc;
+extern DMA2D_HandleTypeDef hdma2d;
 
 // Master touch screen status
 static TsInfo ts_info;
 
-struct _shared {
-	uint32_t generator_index;
-};
-volatile struct _shared * const shared_data = (struct _shared *)0x38001000;
+volatile struct _shared * const shared_data = (struct _shared *)SHARED_DATA_ADDRESS;
 
 /**
  * @brief Lvgl callback used by the library that gets called after the rendering has finished
@@ -58,9 +128,60 @@ static void _lv_flush_callback(lv_display_t * display, const lv_area_t * area, u
         .Backcolor.Green = 0,
         .Backcolor.Red = 0
     };
-    HAL_LTDC_ConfigLayer(&hltdc, &pLayerCfg, 0);
+    HAL_LTDC_ConfigLayer(&hltdc, &pLayerCfg, LCD_BACKGROUND_LAYER);
     lv_display_flush_ready(display);
 }
+
+/**
+ * @brief Show the frame buffer of the waveforms on the LTDC foreground layer over the chart
+ *
+ * @details The transparent pixels of the layer show the user interface of the background
+ * layer below, so the graticule is not redrawn when the waveforms change
+ * The layer is in L8 format with the waveform palette loaded inside its CLUT and the
+ * transparent palette entry is removed with the color keying
+ *
+ * @param area The content area of the chart in screen coordinates
+ */
+static void _lv_api_waveform_layer_init(const lv_area_t * area) {
+    LTDC_LayerCfgTypeDef pLayerCfg = {
+        .WindowX0 = area->x1,
+        .WindowX1 = area->x1 + waveform_get_width(),
+        .WindowY0 = area->y1,
+        .WindowY1 = area->y1 + waveform_get_height(),
+        .PixelFormat = LTDC_PIXEL_FORMAT_L8,
+        .Alpha = 255,
+        .Alpha0 = 0,
+        .BlendingFactor1 = LTDC_BLENDING_FACTOR1_PAxCA,
+        .BlendingFactor2 = LTDC_BLENDING_FACTOR2_PAxCA,
+        .FBStartAdress = (uint32_t)waveform_get_buffer(),
+        .ImageWidth = waveform_get_width(),
+        .ImageHeight = waveform_get_height(),
+        .Backcolor.Blue = 0,
+        .Backcolor.Green = 0,
+        .Backcolor.Red = 0
+    };
+    HAL_LTDC_ConfigLayer(&hltdc, &pLayerCfg, LCD_WAVEFORM_LAYER);
+
+    HAL_LTDC_ConfigCLUT(&hltdc, waveform_get_palette(), WAVEFORM_PALETTE_SIZE, LCD_WAVEFORM_LAYER);
+    HAL_LTDC_EnableCLUT(&hltdc, LCD_WAVEFORM_LAYER);
+    HAL_LTDC_ConfigColorKeying(&hltdc, WAVEFORM_TRANSPARENT, LCD_WAVEFORM_LAYER);
+    HAL_LTDC_EnableColorKeying(&hltdc, LCD_WAVEFORM_LAYER);
+}
+
+/**
+ * @brief Enable or disable the LTDC foreground layer of the waveforms
+ *
+ * @param handler A pointer to the LVGL handler structure
+ * @param enabled True to show the waveforms, false to hide them
+ */
+static void _lv_api_waveform_layer_set_enable(LvHandler * handler, bool enabled) {
+    if (enabled)
+        __HAL_LTDC_LAYER_ENABLE(&hltdc, LCD_WAVEFORM_LAYER);
+    else
+        __HAL_LTDC_LAYER_DISABLE(&hltdc, LCD_WAVEFORM_LAYER);
+    __HAL_LTDC_RELOAD_IMMEDIATE_CONFIG(&hltdc);
+    handler->waveform_layer_enabled = enabled;
+}
 /**
  * @brief Apply all the custom styles to the theme
  *
@@ -260,6 +381,23 @@ static void _lv_api_menu_btn_event_handler(lv_event_t * e) {
         lv_obj_add_flag(handler->menu, LV_OBJ_FLAG_HIDDEN);
 }
 
+/**
+ * @brief Show only the trigger line of the channel used as trigger source
+ *
+ * @details No line is shown if the trigger is disabled or the source is not a channel
+ *
+ * @param handler A pointer to the lvgl handler structure
+ */
+static void _lv_api_show_trigger_line(LvHandler * handler) {
+    const ChartHandlerChannel src = chart_handler_get_trigger_channel(&handler->chart_handler);
+    for (ChartHandlerChannel ch = CHART_HANDLER_CHANNEL_1; ch < CHART_HANDLER_CHANNEL_COUNT; ++ch) {
+        if (ch == src && chart_handler_is_trigger_enabled(&handler->chart_handler))
+            lv_api_update_trigger_line(handler, ch, ADC_VALUE_TO_VOLTAGE(handler->chart_handler.trigger[ch]));
+        else
+            lv_api_hide_trigger_line(handler, ch);
+    }
+}
+
 static void _lv_api_trigger_checkbox_handler_asc(lv_event_t * e) {
     LvHandler * handler = (LvHandler *)lv_event_get_user_data(e);
     lv_event_code_t code = lv_event_get_code(e);
@@ -268,17 +406,12 @@ static void _lv_api_trigger_checkbox_handler_asc(lv_event_t * e) {
         bool checked = lv_obj_get_state(obj) & LV_STATE_CHECKED;
         handler->chart_handler.ascending_trigger = checked;
 
-        // TODO: Manage second channel
-        ChartHandlerChannel ch = CHART_HANDLER_CHANNEL_1;
-        if (!checked && !handler->chart_handler.descending_trigger)
-            lv_api_hide_trigger_line(handler, ch);
-        else {
+        if (checked) {
             // Uncheck other button
             lv_obj_remove_state(handler->trigger_checkbox_desc, LV_STATE_CHECKED);
             handler->chart_handler.descending_trigger = false;
-
-            lv_api_update_trigger_line(handler, ch, ADC_VALUE_TO_VOLTAGE(handler->chart_handler.trigger[ch]));
         }
+        _lv_api_show_trigger_line(handler);
     }
 }
 
@@ -290,17 +423,169 @@ static void _lv_api_trigger_checkbox_handler_desc(lv_event_t * e) {
         bool checked = lv_obj_get_state(obj) & LV_STATE_CHECKED;
         handler->chart_handler.descending_trigger = checked;
 
-        // TODO: Manage second channel
-        ChartHandlerChannel ch = CHART_HANDLER_CHANNEL_1;
-        if (!checked && !handler->chart_handler.ascending_trigger)
-            lv_api_hide_trigger_line(handler, ch);
-        else {
+        if (checked) {
             // Uncheck other button
             lv_obj_remove_state(handler->trigger_checkbox_asc, LV_STATE_CHECKED);
             handler->chart_handler.ascending_trigger = false;
+        }
+        _lv_api_show_trigger_line(handler);
+    }
+}
 
-            lv_api_update_trigger_line(handler, ch, ADC_VALUE_TO_VOLTAGE(handler->chart_handler.trigger[ch]));
+static void _lv_api_trigger_checkbox_handler_watchdog(lv_event_t * e) {
+    lv_event_code_t code = lv_event_get_code(e);
+    lv_obj_t * obj = lv_event_get_target(e);
+    if (code == LV_EVENT_VALUE_CHANGED) {
+        bool checked = lv_obj_get_state(obj) & LV_STATE_CHECKED;
+        acquisition_set_trigger_watchdog(checked);
+    }
+}
+
+static void _lv_api_trigger_mode_dropdown_handler(lv_event_t * e) {
+    LvHandler * handler = (LvHandler *)lv_event_get_user_data(e);
+    lv_event_code_t code = lv_event_get_code(e);
+    lv_obj_t * obj = lv_event_get_target(e);
+    if (code == LV_EVENT_VALUE_CHANGED) {
+        uint32_t selected = lv_dropdown_get_selected(obj);
+        chart_handler_set_trigger_mode(&handler->chart_handler, (ChartHandlerTriggerMode)selected);
+    }
+}
+
+static void _lv_api_trigger_source_dropdown_handler(lv_event_t * e) {
+    LvHandler * handler = (LvHandler *)lv_event_get_user_data(e);
+    lv_event_code_t code = lv_event_get_code(e);
+    lv_obj_t * obj = lv_event_get_target(e);
+    if (code == LV_EVENT_VALUE_CHANGED) {
+        uint32_t selected = lv_dropdown_get_selected(obj);
+        chart_handler_set_trigger_source(&handler->chart_handler, (ChartHandlerTriggerSource)selected);
+        _lv_api_show_trigger_line(handler);
+    }
+}
+
+static void _lv_api_holdoff_dropdown_handler(lv_event_t * e) {
+    LvHandler * handler = (LvHandler *)lv_event_get_user_data(e);
+    lv_event_code_t code = lv_event_get_code(e);
+    lv_obj_t * obj = lv_event_get_target(e);
+    if (code == LV_EVENT_VALUE_CHANGED) {
+        uint32_t selected = lv_dropdown_get_selected(obj);
+        if (selected < LV_API_HOLDOFF_COUNT)
+            chart_handler_set_trigger_holdoff(&handler->chart_handler, holdoff_times[selected]);
+    }
+}
+
+static void _lv_api_trigger_position_dropdown_handler(lv_event_t * e) {
+    LvHandler * handler = (LvHandler *)lv_event_get_user_data(e);
+    lv_event_code_t code = lv_event_get_code(e);
+    lv_obj_t * obj = lv_event_get_target(e);
+    if (code == LV_EVENT_VALUE_CHANGED) {
+        uint32_t selected = lv_dropdown_get_selected(obj);
+        if (selected < LV_API_TRIGGER_POSITION_COUNT)
+            chart_handler_set_trigger_position(&handler->chart_handler, trigger_positions[selected]);
+    }
+}
+
+static void _lv_api_trigger_delay_dropdown_handler(lv_event_t * e) {
+    LvHandler * handler = (LvHandler *)lv_event_get_user_data(e);
+    lv_event_code_t code = lv_event_get_code(e);
+    lv_obj_t * obj = lv_event_get_target(e);
+    if (code == LV_EVENT_VALUE_CHANGED) {
+        uint32_t selected = lv_dropdown_get_selected(obj);
+        if (selected < LV_API_TRIGGER_DELAY_COUNT)
+            chart_handler_set_trigger_delay(&handler->chart_handler, trigger_delays[selected]);
+    }
+}
+
+static void _lv_api_trigger_hysteresis_dropdown_handler(lv_event_t * e) {
+    LvHandler * handler = (LvHandler *)lv_event_get_user_data(e);
+    lv_event_code_t code = lv_event_get_code(e);
+    lv_obj_t * obj = lv_event_get_target(e);
+    if (code == LV_EVENT_VALUE_CHANGED) {
+        uint32_t selected = lv_dropdown_get_selected(obj);
+        if (selected < LV_API_TRIGGER_HYSTERESIS_COUNT)
+            chart_handler_set_trigger_hysteresis(&handler->chart_handler, ADC_VOLTAGE_TO_VALUE(trigger_hysteresis[selected]));
+    }
+}
+
+static void _lv_api_trigger_type_dropdown_handler(lv_event_t * e) {
+    LvHandler * handler = (LvHandler *)lv_event_get_user_data(e);
+    lv_event_code_t code = lv_event_get_code(e);
+    lv_obj_t * obj = lv_event_get_target(e);
+    if (code == LV_EVENT_VALUE_CHANGED) {
+        uint32_t selected = lv_dropdown_get_selected(obj);
+        chart_handler_set_trigger_type(&handler->chart_handler, (ChartHandlerTriggerType)selected);
+    }
+}
+
+static void _lv_api_trigger_condition_dropdown_handler(lv_event_t * e) {
+    LvHandler * handler = (LvHandler *)lv_event_get_user_data(e);
+    lv_event_code_t code = lv_event_get_code(e);
+    lv_obj_t * obj = lv_event_get_target(e);
+    if (code == LV_EVENT_VALUE_CHANGED) {
+        uint32_t selected = lv_dropdown_get_selected(obj);
+        chart_handler_set_trigger_condition(&handler->chart_handler, (ChartHandlerTriggerCondition)selected);
+    }
+}
+
+static void _lv_api_trigger_limit_dropdown_handler(lv_event_t * e) {
+    LvHandler * handler = (LvHandler *)lv_event_get_user_data(e);
+    lv_event_code_t code = lv_event_get_code(e);
+    if (code == LV_EVENT_VALUE_CHANGED) {
+        uint32_t low = lv_dropdown_get_selected(handler->trigger_limit_low_dropdown);
+        uint32_t high = lv_dropdown_get_selected(handler->trigger_limit_high_dropdown);
+        if (low >= LV_API_TRIGGER_LIMIT_COUNT || high >= LV_API_TRIGGER_LIMIT_COUNT)
+            return;
+
+        // The upper limit follows the lower one
+        if (high < low) {
+            high = low;
+            lv_dropdown_set_selected(handler->trigger_limit_high_dropdown, high);
         }
+        chart_handler_set_trigger_limits(&handler->chart_handler, trigger_limits[low], trigger_limits[high]);
+    }
+}
+
+/**
+ * @brief Select the option of the second level currently used by the trigger source
+ *
+ * @param handler A pointer to the lvgl handler structure
+ */
+static void _lv_api_trigger_second_select(LvHandler * handler) {
+    ChartHandlerChannel ch = chart_handler_get_trigger_channel(&handler->chart_handler);
+    if (ch >= CHART_HANDLER_CHANNEL_COUNT)
+        ch = CHART_HANDLER_CHANNEL_1;
+    for (size_t i = 0U; i < LV_API_TRIGGER_SECOND_COUNT; ++i) {
+        if (ADC_VOLTAGE_TO_VALUE(trigger_seconds[i]) == chart_handler_get_trigger_second(&handler->chart_handler, ch))
+            lv_dropdown_set_selected(handler->trigger_second_dropdown, i);
+    }
+}
+
+static void _lv_api_trigger_second_dropdown_handler(lv_event_t * e) {
+    LvHandler * handler = (LvHandler *)lv_event_get_user_data(e);
+    lv_event_code_t code = lv_event_get_code(e);
+    lv_obj_t * obj = lv_event_get_target(e);
+    if (code == LV_EVENT_VALUE_CHANGED) {
+        uint32_t selected = lv_dropdown_get_selected(obj);
+        if (selected >= LV_API_TRIGGER_SECOND_COUNT)
+            return;
+        bool valid = true;
+        for (size_t ch = 0U; ch < CHART_HANDLER_CHANNEL_COUNT; ++ch) {
+            if (chart_handler_set_trigger_second(&handler->chart_handler, ch, ADC_VOLTAGE_TO_VALUE(trigger_seconds[selected])) != HAL_OK)
+                valid = false;
+        }
+
+        // A level on the wrong side of the trigger level is rejected, show the one still used
+        if (!valid)
+            _lv_api_trigger_second_select(handler);
+    }
+}
+
+static void _lv_api_equivalent_time_checkbox_handler(lv_event_t * e) {
+    LvHandler * handler = (LvHandler *)lv_event_get_user_data(e);
+    lv_event_code_t code = lv_event_get_code(e);
+    lv_obj_t * obj = lv_event_get_target(e);
+    if (code == LV_EVENT_VALUE_CHANGED) {
+        bool checked = lv_obj_get_state(obj) & LV_STATE_CHECKED;
+        chart_handler_set_equivalent_time(&handler->chart_handler, checked);
     }
 }
 
@@ -324,6 +609,149 @@ static void _lv_api_knob_switch_handler(lv_event_t * e) {
     }
 }
 
+static void _lv_api_record_dropdown_handler(lv_event_t * e) {
+    lv_event_code_t code = lv_event_get_code(e);
+    lv_obj_t * obj = lv_event_get_target(e);
+    if (code == LV_EVENT_VALUE_CHANGED) {
+        uint32_t selected = lv_dropdown_get_selected(obj);
+        if (selected < LV_API_RECORD_LENGTH_COUNT)
+            record_set_length(record_lengths[selected]);
+    }
+}
+
+static void _lv_api_acquisition_dropdown_handler(lv_event_t * e) {
+    LvHandler * handler = (LvHandler *)lv_event_get_user_data(e);
+    lv_event_code_t code = lv_event_get_code(e);
+    lv_obj_t * obj = lv_event_get_target(e);
+    if (code == LV_EVENT_VALUE_CHANGED) {
+        uint32_t selected = lv_dropdown_get_selected(obj);
+        chart_handler_set_acquisition_mode(&handler->chart_handler, (ChartHandlerAcquisitionMode)selected);
+    }
+}
+
+static void _lv_api_pacing_dropdown_handler(lv_event_t * e) {
+    lv_event_code_t code = lv_event_get_code(e);
+    lv_obj_t * obj = lv_event_get_target(e);
+    if (code == LV_EVENT_VALUE_CHANGED) {
+        uint32_t selected = lv_dropdown_get_selected(obj);
+        if (selected < ACQUISITION_PACING_COUNT)
+            acquisition_set_pacing((AcquisitionPacing)selected);
+    }
+}
+
+static void _lv_api_calibration_low_btn_handler(lv_event_t * e) {
+    LV_UNUSED(e);
+    acquisition_calibrate(ACQUISITION_CALIBRATION_LOW);
+}
+
+static void _lv_api_calibration_high_btn_handler(lv_event_t * e) {
+    LV_UNUSED(e);
+    acquisition_calibrate(ACQUISITION_CALIBRATION_HIGH);
+}
+
+static void _lv_api_average_dropdown_handler(lv_event_t * e) {
+    LvHandler * handler = (LvHandler *)lv_event_get_user_data(e);
+    lv_event_code_t code = lv_event_get_code(e);
+    lv_obj_t * obj = lv_event_get_target(e);
+    if (code == LV_EVENT_VALUE_CHANGED) {
+        uint32_t selected = lv_dropdown_get_selected(obj);
+        chart_handler_set_average_count(&handler->chart_handler, CHART_HANDLER_AVERAGE_MIN_COUNT << selected);
+    }
+}
+
+static void _lv_api_persistence_dropdown_handler(lv_event_t * e) {
+    LvHandler * handler = (LvHandler *)lv_event_get_user_data(e);
+    lv_event_code_t code = lv_event_get_code(e);
+    lv_obj_t * obj = lv_event_get_target(e);
+    if (code == LV_EVENT_VALUE_CHANGED) {
+        uint32_t selected = lv_dropdown_get_selected(obj);
+        if (selected >= LV_API_PERSISTENCE_COUNT)
+            return;
+        persistence_set_decay_time(persistence_times[selected]);
+    }
+}
+
+/**
+ * @brief Show the displayed segment with its time since the first segment and the previous one
+ *
+ * @param handler A pointer to the lvgl handler structure
+ */
+static void _lv_api_segment_set_text(LvHandler * handler) {
+    const ChartHandlerChannel ch = CHART_HANDLER_CHANNEL_1;
+    const size_t count = segments_get_count(ch);
+    const size_t view = chart_handler_get_segment_view(&handler->chart_handler);
+
+    char msg[LV_API_SEGMENT_LABEL_SIZE] = { 0 };
+    if (count == 0U)
+        snprintf(msg, LV_API_SEGMENT_LABEL_SIZE, "No segments");
+    else if (view == CHART_HANDLER_SEGMENT_OVERLAY)
+        snprintf(msg, LV_API_SEGMENT_LABEL_SIZE, "%u segments", (unsigned int)count);
+    else {
+        const size_t s = view < count ? view : count - 1U;
+        const double first = segments_get(ch, 0U)->timestamp;
+        const double time = segments_get(ch, s)->timestamp;
+        const double prev = s > 0U ? segments_get(ch, s - 1U)->timestamp : time;
+        snprintf(
+            msg,
+            LV_API_SEGMENT_LABEL_SIZE,
+            "%u/%u at %.1f us (+%.1f us)",
+            (unsigned int)(s + 1U),
+            (unsigned int)count,
+            time - first,
+            time - prev
+        );
+    }
+    lv_label_set_text(handler->segment_label, msg);
+}
+
+static void _lv_api_segments_dropdown_handler(lv_event_t * e) {
+    LvHandler * handler = (LvHandler *)lv_event_get_user_data(e);
+    lv_event_code_t code = lv_event_get_code(e);
+    lv_obj_t * obj = lv_event_get_target(e);
+    if (code == LV_EVENT_VALUE_CHANGED) {
+        uint32_t selected = lv_dropdown_get_selected(obj);
+        if (selected >= LV_API_SEGMENTS_COUNT)
+            return;
+        segments_set_length(segment_lengths[selected]);
+        for (size_t ch = 0U; ch < CHART_HANDLER_CHANNEL_COUNT; ++ch)
+            chart_handler_invalidate(&handler->chart_handler, ch);
+        _lv_api_segment_set_text(handler);
+    }
+}
+
+static void _lv_api_segment_prev_btn_handler(lv_event_t * e) {
+    LvHandler * handler = (LvHandler *)lv_event_get_user_data(e);
+    const size_t view = chart_handler_get_segment_view(&handler->chart_handler);
+    if (view != CHART_HANDLER_SEGMENT_OVERLAY && view > 0U)
+        chart_handler_set_segment_view(&handler->chart_handler, view - 1U);
+    _lv_api_segment_set_text(handler);
+}
+
+static void _lv_api_segment_next_btn_handler(lv_event_t * e) {
+    LvHandler * handler = (LvHandler *)lv_event_get_user_data(e);
+    const size_t view = chart_handler_get_segment_view(&handler->chart_handler);
+    if (view != CHART_HANDLER_SEGMENT_OVERLAY && view + 1U < segments_get_count(CHART_HANDLER_CHANNEL_1))
+        chart_handler_set_segment_view(&handler->chart_handler, view + 1U);
+    _lv_api_segment_set_text(handler);
+}
+
+static void _lv_api_segment_overlay_checkbox_handler(lv_event_t * e) {
+    LvHandler * handler = (LvHandler *)lv_event_get_user_data(e);
+    lv_event_code_t code = lv_event_get_code(e);
+    lv_obj_t * obj = lv_event_get_target(e);
+    if (code == LV_EVENT_VALUE_CHANGED) {
+        bool checked = lv_obj_get_state(obj) & LV_STATE_CHECKED;
+        chart_handler_set_segment_view(&handler->chart_handler, checked ? CHART_HANDLER_SEGMENT_OVERLAY : 0U);
+
+        // The segments are drawn over each other inside the persistence buffers
+        if (checked && !persistence_is_enabled()) {
+            lv_dropdown_set_selected(handler->persistence_dropdown, LV_API_PERSISTENCE_COUNT - 1U);
+            lv_obj_send_event(handler->persistence_dropdown, LV_EVENT_VALUE_CHANGED, NULL);
+        }
+        _lv_api_segment_set_text(handler);
+    }
+}
+
 static void _lv_api_signal_generator_event_handler(lv_event_t * e) {
     lv_obj_t * obj = lv_event_get_target(e);
     shared_data->generator_index = lv_obj_get_index(obj);
@@ -368,6 +796,134 @@ void _lv_api_init_settings_tab(LvHandler * handler, lv_obj_t * tabview) {
     lv_obj_add_event_cb(handler->trigger_checkbox_desc, _lv_api_trigger_checkbox_handler_desc, LV_EVENT_ALL, handler);
     lv_obj_update_layout(handler->trigger_checkbox_desc);
 
+    handler->trigger_checkbox_watchdog = lv_checkbox_create(settings_tab);
+    lv_checkbox_set_text(handler->trigger_checkbox_watchdog, "Search the trigger with the ADC watchdog");
+    lv_obj_add_event_cb(handler->trigger_checkbox_watchdog, _lv_api_trigger_checkbox_handler_watchdog, LV_EVENT_ALL, handler);
+    lv_obj_update_layout(handler->trigger_checkbox_watchdog);
+
+    handler->equivalent_time_checkbox = lv_checkbox_create(settings_tab);
+    lv_checkbox_set_text(handler->equivalent_time_checkbox, "Equivalent-time sampling (repetitive signals)");
+    lv_obj_add_event_cb(handler->equivalent_time_checkbox, _lv_api_equivalent_time_checkbox_handler, LV_EVENT_ALL, handler);
+    lv_obj_update_layout(handler->equivalent_time_checkbox);
+
+    lv_obj_t * trigger_container = lv_obj_create(settings_tab);
+    lv_obj_set_flex_flow(trigger_container, LV_FLEX_FLOW_ROW_WRAP);
+    lv_obj_set_flex_align(trigger_container, LV_FLEX_ALIGN_START, LV_FLEX_ALIGN_CENTER, LV_FLEX_ALIGN_CENTER);
+
+    lv_obj_t * trigger_mode_label = lv_label_create(trigger_container);
+    lv_label_set_text(trigger_mode_label, "Trigger mode");
+    handler->trigger_mode_dropdown = lv_dropdown_create(trigger_container);
+    lv_dropdown_set_options_static(handler->trigger_mode_dropdown, LV_API_TRIGGER_MODE_OPTIONS);
+    lv_dropdown_set_selected(handler->trigger_mode_dropdown, chart_handler_get_trigger_mode(&handler->chart_handler));
+    lv_obj_add_event_cb(handler->trigger_mode_dropdown, _lv_api_trigger_mode_dropdown_handler, LV_EVENT_ALL, handler);
+
+    lv_obj_t * trigger_source_label = lv_label_create(trigger_container);
+    lv_label_set_text(trigger_source_label, "Source");
+    handler->trigger_source_dropdown = lv_dropdown_create(trigger_container);
+    lv_dropdown_set_options_static(handler->trigger_source_dropdown, LV_API_TRIGGER_SOURCE_OPTIONS);
+    lv_dropdown_set_selected(handler->trigger_source_dropdown, chart_handler_get_trigger_source(&handler->chart_handler));
+    lv_obj_add_event_cb(handler->trigger_source_dropdown, _lv_api_trigger_source_dropdown_handler, LV_EVENT_ALL, handler);
+
+    lv_obj_t * holdoff_label = lv_label_create(trigger_container);
+    lv_label_set_text(holdoff_label, "Holdoff");
+    handler->holdoff_dropdown = lv_dropdown_create(trigger_container);
+    lv_dropdown_set_options_static(handler->holdoff_dropdown, LV_API_HOLDOFF_OPTIONS);
+    for (size_t i = 0U; i < LV_API_HOLDOFF_COUNT; ++i) {
+        if (holdoff_times[i] == chart_handler_get_trigger_holdoff(&handler->chart_handler))
+            lv_dropdown_set_selected(handler->holdoff_dropdown, i);
+    }
+    lv_obj_add_event_cb(handler->holdoff_dropdown, _lv_api_holdoff_dropdown_handler, LV_EVENT_ALL, handler);
+
+    lv_obj_t * trigger_position_label = lv_label_create(trigger_container);
+    lv_label_set_text(trigger_position_label, "Position");
+    handler->trigger_position_dropdown = lv_dropdown_create(trigger_container);
+    lv_dropdown_set_options_static(handler->trigger_position_dropdown, LV_API_TRIGGER_POSITION_OPTIONS);
+    for (size_t i = 0U; i < LV_API_TRIGGER_POSITION_COUNT; ++i) {
+        if (trigger_positions[i] == chart_handler_get_trigger_position(&handler->chart_handler))
+            lv_dropdown_set_selected(handler->trigger_position_dropdown, i);
+    }
+    lv_obj_add_event_cb(handler->trigger_position_dropdown, _lv_api_trigger_position_dropdown_handler, LV_EVENT_ALL, handler);
+
+    lv_obj_t * trigger_delay_label = lv_label_create(trigger_container);
+    lv_label_set_text(trigger_delay_label, "Delay");
+    handler->trigger_delay_dropdown = lv_dropdown_create(trigger_container);
+    lv_dropdown_set_options_static(handler->trigger_delay_dropdown, LV_API_TRIGGER_DELAY_OPTIONS);
+    for (size_t i = 0U; i < LV_API_TRIGGER_DELAY_COUNT; ++i) {
+        if (trigger_delays[i] == chart_handler_get_trigger_delay(&handler->chart_handler))
+            lv_dropdown_set_selected(handler->trigger_delay_dropdown, i);
+    }
+    lv_obj_add_event_cb(handler->trigger_delay_dropdown, _lv_api_trigger_delay_dropdown_handler, LV_EVENT_ALL, handler);
+
+    lv_obj_t * trigger_hysteresis_label = lv_label_create(trigger_container);
+    lv_label_set_text(trigger_hysteresis_label, "Hysteresis");
+    handler->trigger_hysteresis_dropdown = lv_dropdown_create(trigger_container);
+    lv_dropdown_set_options_static(handler->trigger_hysteresis_dropdown, LV_API_TRIGGER_HYSTERESIS_OPTIONS);
+    for (size_t i = 0U; i < LV_API_TRIGGER_HYSTERESIS_COUNT; ++i) {
+        if (ADC_VOLTAGE_TO_VALUE(trigger_hysteresis[i]) == chart_handler_get_trigger_hysteresis(&handler->chart_handler))
+            lv_dropdown_set_selected(handler->trigger_hysteresis_dropdown, i);
+    }
+    lv_obj_add_event_cb(handler->trigger_hysteresis_dropdown, _lv_api_trigger_hysteresis_dropdown_handler, LV_EVENT_ALL, handler);
+
+    // Set style which cant be set inside the theme
+    lv_obj_set_style_margin_top(trigger_container, 25U, LV_PART_MAIN);
+    lv_obj_set_style_margin_left(trigger_container, 8U, LV_PART_MAIN);
+    lv_obj_set_style_bg_color(trigger_container, LV_BLACK, LV_PART_MAIN);
+    lv_obj_set_style_text_color(trigger_mode_label, LV_WHITE, LV_PART_MAIN);
+    lv_obj_set_style_text_color(trigger_source_label, LV_WHITE, LV_PART_MAIN);
+    lv_obj_set_style_text_color(holdoff_label, LV_WHITE, LV_PART_MAIN);
+    lv_obj_set_style_text_color(trigger_position_label, LV_WHITE, LV_PART_MAIN);
+    lv_obj_set_style_text_color(trigger_delay_label, LV_WHITE, LV_PART_MAIN);
+    lv_obj_set_style_text_color(trigger_hysteresis_label, LV_WHITE, LV_PART_MAIN);
+
+    lv_obj_t * trigger_type_container = lv_obj_create(settings_tab);
+    lv_obj_set_flex_flow(trigger_type_container, LV_FLEX_FLOW_ROW_WRAP);
+    lv_obj_set_flex_align(trigger_type_container, LV_FLEX_ALIGN_START, LV_FLEX_ALIGN_CENTER, LV_FLEX_ALIGN_CENTER);
+
+    lv_obj_t * trigger_type_label = lv_label_create(trigger_type_container);
+    lv_label_set_text(trigger_type_label, "Trigger type");
+    handler->trigger_type_dropdown = lv_dropdown_create(trigger_type_container);
+    lv_dropdown_set_options_static(handler->trigger_type_dropdown, LV_API_TRIGGER_TYPE_OPTIONS);
+    lv_dropdown_set_selected(handler->trigger_type_dropdown, chart_handler_get_trigger_type(&handler->chart_handler));
+    lv_obj_add_event_cb(handler->trigger_type_dropdown, _lv_api_trigger_type_dropdown_handler, LV_EVENT_ALL, handler);
+
+    lv_obj_t * trigger_condition_label = lv_label_create(trigger_type_container);
+    lv_label_set_text(trigger_condition_label, "Time");
+    handler->trigger_condition_dropdown = lv_dropdown_create(trigger_type_container);
+    lv_dropdown_set_options_static(handler->trigger_condition_dropdown, LV_API_TRIGGER_CONDITION_OPTIONS);
+    lv_dropdown_set_selected(handler->trigger_condition_dropdown, chart_handler_get_trigger_condition(&handler->chart_handler));
+    lv_obj_add_event_cb(handler->trigger_condition_dropdown, _lv_api_trigger_condition_dropdown_handler, LV_EVENT_ALL, handler);
+
+    lv_obj_t * trigger_limit_label = lv_label_create(trigger_type_container);
+    lv_label_set_text(trigger_limit_label, "Limits");
+    handler->trigger_limit_low_dropdown = lv_dropdown_create(trigger_type_container);
+    lv_dropdown_set_options_static(handler->trigger_limit_low_dropdown, LV_API_TRIGGER_LIMIT_OPTIONS);
+    handler->trigger_limit_high_dropdown = lv_dropdown_create(trigger_type_container);
+    lv_dropdown_set_options_static(handler->trigger_limit_high_dropdown, LV_API_TRIGGER_LIMIT_OPTIONS);
+    for (size_t i = 0U; i < LV_API_TRIGGER_LIMIT_COUNT; ++i) {
+        if (trigger_limits[i] == handler->chart_handler.trigger_limit_low)
+            lv_dropdown_set_selected(handler->trigger_limit_low_dropdown, i);
+        if (trigger_limits[i] == handler->chart_handler.trigger_limit_high)
+            lv_dropdown_set_selected(handler->trigger_limit_high_dropdown, i);
+    }
+    lv_obj_add_event_cb(handler->trigger_limit_low_dropdown, _lv_api_trigger_limit_dropdown_handler, LV_EVENT_ALL, handler);
+    lv_obj_add_event_cb(handler->trigger_limit_high_dropdown, _lv_api_trigger_limit_dropdown_handler, LV_EVENT_ALL, handler);
+
+    lv_obj_t * trigger_second_label = lv_label_create(trigger_type_container);
+    lv_label_set_text(trigger_second_label, "Second level");
+    handler->trigger_second_dropdown = lv_dropdown_create(trigger_type_container);
+    lv_dropdown_set_options_static(handler->trigger_second_dropdown, LV_API_TRIGGER_SECOND_OPTIONS);
+    _lv_api_trigger_second_select(handler);
+    lv_obj_add_event_cb(handler->trigger_second_dropdown, _lv_api_trigger_second_dropdown_handler, LV_EVENT_ALL, handler);
+
+    // Set style which cant be set inside the theme
+    lv_obj_set_style_margin_top(trigger_type_container, 25U, LV_PART_MAIN);
+    lv_obj_set_style_margin_left(trigger_type_container, 8U, LV_PART_MAIN);
+    lv_obj_set_style_bg_color(trigger_type_container, LV_BLACK, LV_PART_MAIN);
+    lv_obj_set_style_text_color(trigger_type_label, LV_WHITE, LV_PART_MAIN);
+    lv_obj_set_style_text_color(trigger_condition_label, LV_WHITE, LV_PART_MAIN);
+    lv_obj_set_style_text_color(trigger_limit_label, LV_WHITE, LV_PART_MAIN);
+    lv_obj_set_style_text_color(trigger_second_label, LV_WHITE, LV_PART_MAIN);
+
     lv_obj_t * knob_container = lv_obj_create(settings_tab);
     lv_obj_set_flex_flow(knob_container, LV_FLEX_FLOW_ROW);
 
@@ -385,6 +941,149 @@ void _lv_api_init_settings_tab(LvHandler * handler, lv_obj_t * tabview) {
     lv_obj_set_align(handler->knob_label, LV_ALIGN_RIGHT_MID);
     lv_obj_set_style_text_color(handler->knob_label, LV_WHITE, LV_PART_MAIN);
 
+    lv_obj_t * record_container = lv_obj_create(settings_tab);
+    lv_obj_set_flex_flow(record_container, LV_FLEX_FLOW_ROW);
+    lv_obj_set_flex_align(record_container, LV_FLEX_ALIGN_START, LV_FLEX_ALIGN_CENTER, LV_FLEX_ALIGN_CENTER);
+
+    lv_obj_t * record_label = lv_label_create(record_container);
+    lv_label_set_text(record_label, "Record length");
+    handler->record_dropdown = lv_dropdown_create(record_container);
+    lv_dropdown_set_options_static(handler->record_dropdown, LV_API_RECORD_LENGTH_OPTIONS);
+    for (size_t i = 0U; i < LV_API_RECORD_LENGTH_COUNT; ++i) {
+        if (record_lengths[i] == record_get_length())
+            lv_dropdown_set_selected(handler->record_dropdown, i);
+    }
+    lv_obj_add_event_cb(handler->record_dropdown, _lv_api_record_dropdown_handler, LV_EVENT_ALL, handler);
+
+    // Set style which cant be set inside the theme
+    lv_obj_set_style_margin_top(record_container, 25U, LV_PART_MAIN);
+    lv_obj_set_style_margin_left(record_container, 8U, LV_PART_MAIN);
+    lv_obj_set_style_bg_color(record_container, LV_BLACK, LV_PART_MAIN);
+    lv_obj_set_style_text_color(record_label, LV_WHITE, LV_PART_MAIN);
+
+    lv_obj_t * acquisition_container = lv_obj_create(settings_tab);
+    lv_obj_set_flex_flow(acquisition_container, LV_FLEX_FLOW_ROW_WRAP);
+    lv_obj_set_flex_align(acquisition_container, LV_FLEX_ALIGN_START, LV_FLEX_ALIGN_CENTER, LV_FLEX_ALIGN_CENTER);
+
+    lv_obj_t * acquisition_label = lv_label_create(acquisition_container);
+    lv_label_set_text(acquisition_label, "Acquisition mode");
+    handler->acquisition_dropdown = lv_dropdown_create(acquisition_container);
+    lv_dropdown_set_options_static(handler->acquisition_dropdown, LV_API_ACQUISITION_MODE_OPTIONS);
+    lv_dropdown_set_selected(handler->acquisition_dropdown, chart_handler_get_acquisition_mode(&handler->chart_handler));
+    lv_obj_add_event_cb(handler->acquisition_dropdown, _lv_api_acquisition_dropdown_handler, LV_EVENT_ALL, handler);
+
+    lv_obj_t * average_label = lv_label_create(acquisition_container);
+    lv_label_set_text(average_label, "Averages");
+    handler->average_dropdown = lv_dropdown_create(acquisition_container);
+    lv_dropdown_set_options_static(handler->average_dropdown, LV_API_AVERAGE_COUNT_OPTIONS);
+    for (uint32_t i = 0U; (CHART_HANDLER_AVERAGE_MIN_COUNT << i) <= CHART_HANDLER_AVERAGE_MAX_COUNT; ++i) {
+        if ((CHART_HANDLER_AVERAGE_MIN_COUNT << i) == chart_handler_get_average_count(&handler->chart_handler))
+            lv_dropdown_set_selected(handler->average_dropdown, i);
+    }
+    lv_obj_add_event_cb(handler->average_dropdown, _lv_api_average_dropdown_handler, LV_EVENT_ALL, handler);
+
+    lv_obj_t * pacing_label = lv_label_create(acquisition_container);
+    lv_label_set_text(pacing_label, "Sampling");
+    handler->pacing_dropdown = lv_dropdown_create(acquisition_container);
+    lv_dropdown_set_options_static(handler->pacing_dropdown, LV_API_PACING_OPTIONS);
+    lv_dropdown_set_selected(handler->pacing_dropdown, acquisition_get_pacing());
+    lv_obj_add_event_cb(handler->pacing_dropdown, _lv_api_pacing_dropdown_handler, LV_EVENT_ALL, handler);
+
+    // Set style which cant be set inside the theme
+    lv_obj_set_style_margin_top(acquisition_container, 25U, LV_PART_MAIN);
+    lv_obj_set_style_margin_left(acquisition_container, 8U, LV_PART_MAIN);
+    lv_obj_set_style_bg_color(acquisition_container, LV_BLACK, LV_PART_MAIN);
+    lv_obj_set_style_text_color(acquisition_label, LV_WHITE, LV_PART_MAIN);
+    lv_obj_set_style_text_color(average_label, LV_WHITE, LV_PART_MAIN);
+    lv_obj_set_style_text_color(pacing_label, LV_WHITE, LV_PART_MAIN);
+
+    // Measure the mismatch between the interleaved ADCs with the first channel at a low and then a high level
+    lv_obj_t * calibration_container = lv_obj_create(settings_tab);
+    lv_obj_set_flex_flow(calibration_container, LV_FLEX_FLOW_ROW);
+    lv_obj_set_flex_align(calibration_container, LV_FLEX_ALIGN_START, LV_FLEX_ALIGN_CENTER, LV_FLEX_ALIGN_CENTER);
+
+    lv_obj_t * calibration_label = lv_label_create(calibration_container);
+    lv_label_set_text(calibration_label, "Calibration");
+
+    lv_obj_t * calibration_low_btn = lv_btn_create(calibration_container);
+    lv_obj_add_event_cb(calibration_low_btn, _lv_api_calibration_low_btn_handler, LV_EVENT_CLICKED, handler);
+    lv_obj_t * calibration_low_label = lv_label_create(calibration_low_btn);
+    lv_label_set_text(calibration_low_label, "Low");
+    lv_obj_center(calibration_low_label);
+
+    lv_obj_t * calibration_high_btn = lv_btn_create(calibration_container);
+    lv_obj_add_event_cb(calibration_high_btn, _lv_api_calibration_high_btn_handler, LV_EVENT_CLICKED, handler);
+    lv_obj_t * calibration_high_label = lv_label_create(calibration_high_btn);
+    lv_label_set_text(calibration_high_label, "High");
+    lv_obj_center(calibration_high_label);
+
+    // Set style which cant be set inside the theme
+    lv_obj_set_style_margin_top(calibration_container, 25U, LV_PART_MAIN);
+    lv_obj_set_style_margin_left(calibration_container, 8U, LV_PART_MAIN);
+    lv_obj_set_style_bg_color(calibration_container, LV_BLACK, LV_PART_MAIN);
+    lv_obj_set_style_text_color(calibration_label, LV_WHITE, LV_PART_MAIN);
+
+    lv_obj_t * persistence_container = lv_obj_create(settings_tab);
+    lv_obj_set_flex_flow(persistence_container, LV_FLEX_FLOW_ROW);
+    lv_obj_set_flex_align(persistence_container, LV_FLEX_ALIGN_START, LV_FLEX_ALIGN_CENTER, LV_FLEX_ALIGN_CENTER);
+
+    lv_obj_t * persistence_label = lv_label_create(persistence_container);
+    lv_label_set_text(persistence_label, "Persistence");
+    handler->persistence_dropdown = lv_dropdown_create(persistence_container);
+    lv_dropdown_set_options_static(handler->persistence_dropdown, LV_API_PERSISTENCE_OPTIONS);
+    for (size_t i = 0U; i < LV_API_PERSISTENCE_COUNT; ++i) {
+        if (persistence_times[i] == persistence_get_decay_time())
+            lv_dropdown_set_selected(handler->persistence_dropdown, i);
+    }
+    lv_obj_add_event_cb(handler->persistence_dropdown, _lv_api_persistence_dropdown_handler, LV_EVENT_ALL, handler);
+
+    // Set style which cant be set inside the theme
+    lv_obj_set_style_margin_top(persistence_container, 25U, LV_PART_MAIN);
+    lv_obj_set_style_margin_left(persistence_container, 8U, LV_PART_MAIN);
+    lv_obj_set_style_bg_color(persistence_container, LV_BLACK, LV_PART_MAIN);
+    lv_obj_set_style_text_color(persistence_label, LV_WHITE, LV_PART_MAIN);
+
+    lv_obj_t * segments_container = lv_obj_create(settings_tab);
+    lv_obj_set_flex_flow(segments_container, LV_FLEX_FLOW_ROW_WRAP);
+    lv_obj_set_flex_align(segments_container, LV_FLEX_ALIGN_START, LV_FLEX_ALIGN_CENTER, LV_FLEX_ALIGN_CENTER);
+
+    lv_obj_t * segments_label = lv_label_create(segments_container);
+    lv_label_set_text(segments_label, "Segments");
+    handler->segments_dropdown = lv_dropdown_create(segments_container);
+    lv_dropdown_set_options_static(handler->segments_dropdown, LV_API_SEGMENTS_OPTIONS);
+    for (size_t i = 0U; i < LV_API_SEGMENTS_COUNT; ++i) {
+        if (segment_lengths[i] == segments_get_length())
+            lv_dropdown_set_selected(handler->segments_dropdown, i);
+    }
+    lv_obj_add_event_cb(handler->segments_dropdown, _lv_api_segments_dropdown_handler, LV_EVENT_ALL, handler);
+
+    lv_obj_t * segment_prev_btn = lv_btn_create(segments_container);
+    lv_obj_add_event_cb(segment_prev_btn, _lv_api_segment_prev_btn_handler, LV_EVENT_CLICKED, handler);
+    lv_obj_t * segment_prev_label = lv_label_create(segment_prev_btn);
+    lv_label_set_text(segment_prev_label, LV_SYMBOL_LEFT);
+    lv_obj_center(segment_prev_label);
+
+    lv_obj_t * segment_next_btn = lv_btn_create(segments_container);
+    lv_obj_add_event_cb(segment_next_btn, _lv_api_segment_next_btn_handler, LV_EVENT_CLICKED, handler);
+    lv_obj_t * segment_next_label = lv_label_create(segment_next_btn);
+    lv_label_set_text(segment_next_label, LV_SYMBOL_RIGHT);
+    lv_obj_center(segment_next_label);
+
+    handler->segment_overlay_checkbox = lv_checkbox_create(segments_container);
+    lv_checkbox_set_text(handler->segment_overlay_checkbox, "Overlay");
+    lv_obj_add_event_cb(handler->segment_overlay_checkbox, _lv_api_segment_overlay_checkbox_handler, LV_EVENT_ALL, handler);
+
+    handler->segment_label = lv_label_create(segments_container);
+    _lv_api_segment_set_text(handler);
+
+    // Set style which cant be set inside the theme
+    lv_obj_set_style_margin_top(segments_container, 25U, LV_PART_MAIN);
+    lv_obj_set_style_margin_left(segments_container, 8U, LV_PART_MAIN);
+    lv_obj_set_style_bg_color(segments_container, LV_BLACK, LV_PART_MAIN);
+    lv_obj_set_style_text_color(segments_label, LV_WHITE, LV_PART_MAIN);
+    lv_obj_set_style_text_color(handler->segment_overlay_checkbox, LV_WHITE, LV_PART_MAIN);
+    lv_obj_set_style_text_color(handler->segment_label, LV_WHITE, LV_PART_MAIN);
+
     lv_obj_set_style_bg_color(settings_tab, LV_BLACK, LV_PART_MAIN);
     lv_obj_set_style_pad_all(settings_tab, 30U, LV_PART_MAIN);
 }
@@ -471,27 +1170,30 @@ void _lv_api_chart_init(LvHandler * handler) {
     size_t w = lv_display_get_horizontal_resolution(handler->display);
     size_t h = lv_display_get_vertical_resolution(handler->display);
 
-    // Setup chart
+    // Setup chart, only the graticule is drawn by LVGL while the waveforms are drawn on their own layer
     handler->chart = lv_chart_create(screen);
-    lv_chart_set_type(handler->chart, LV_CHART_TYPE_LINE);
+    lv_chart_set_type(handler->chart, LV_CHART_TYPE_NONE);
     lv_obj_set_size(handler->chart, w, h - HEADER_SIZE);
     lv_obj_align(handler->chart, LV_ALIGN_BOTTOM_MID, 0, 0);
     // lv_obj_center(handler->chart);
 
-    // Set point and line count
+    // Set line count
     lv_chart_set_div_line_count(handler->chart, CHART_HORIZONTAL_LINE_COUNT, CHART_VERTICAL_LINE_COUNT);
-    lv_chart_set_point_count(handler->chart, CHART_POINT_COUNT);
 
-    // Set range values
-    lv_chart_set_range(handler->chart, LV_CHART_AXIS_PRIMARY_Y, 0, CHART_AXIS_PRIMARY_Y_MAX_COORD);
-    lv_chart_set_range(handler->chart, LV_CHART_AXIS_SECONDARY_Y, 0, CHART_AXIS_SECONDARY_Y_MAX_COORD);
+    // Set the color of each channel
+    handler->colors[CHART_HANDLER_CHANNEL_1] = LV_YELLOW;
+    handler->colors[CHART_HANDLER_CHANNEL_2] = LV_PURPLE;
 
-    // Add series of points
-    handler->series[CHART_HANDLER_CHANNEL_1] = lv_chart_add_series(handler->chart, LV_YELLOW, LV_CHART_AXIS_PRIMARY_Y);
-    handler->series[CHART_HANDLER_CHANNEL_2] = lv_chart_add_series(handler->chart, LV_PURPLE, LV_CHART_AXIS_SECONDARY_Y);
+    // The waveforms and the persistence are drawn inside the content area of the chart
+    lv_obj_update_layout(handler->chart);
+    const int32_t content_w = lv_obj_get_content_width(handler->chart);
+    const int32_t content_h = lv_obj_get_content_height(handler->chart);
+    persistence_set_size(content_w, content_h);
+    waveform_set_size(content_w, content_h);
 
     for (size_t ch = 0; ch < CHART_HANDLER_CHANNEL_COUNT; ++ch) {
-        lv_chart_set_ext_y_array(handler->chart, handler->series[ch], handler->channels[ch]);
+        // The color of the waveform and of the persistence are entries of the palette
+        waveform_set_color(ch, lv_color_to_u32(handler->colors[ch]));
 
         // Initialize trigger lines
         handler->trigger_line[ch] = lv_line_create(handler->chart);
@@ -501,6 +1203,11 @@ void _lv_api_chart_init(LvHandler * handler) {
         lv_line_set_points(handler->trigger_line[ch], handler->trigger_points[ch], 2U);
         lv_api_hide_trigger_line(handler, ch);
     }
+
+    lv_area_t content_area;
+    lv_obj_get_content_coords(handler->chart, &content_area);
+    _lv_api_waveform_layer_init(&content_area);
+    _lv_api_waveform_layer_set_enable(handler, true);
 }
 
 void _lv_api_chart_handler_init(LvHandler * handler) {
@@ -546,13 +1253,12 @@ void lv_api_init(
         return;
     memset(handler, 0U, sizeof(LvHandler));
 
-    // Set channels data to 0
-    for (size_t i = 0; i < CHART_HANDLER_CHANNEL_COUNT; ++i)
-        memset(handler->channels[i], LV_CHART_POINT_NONE, CHART_POINT_COUNT * sizeof(int32_t));
-
     // Init LVGL
     lv_init();
 
+    // Move the fills and the image blending to the DMA2D
+    lv_dma2d_init(&hdma2d);
+
     // Create the display
     handler->display = lv_display_create(screen_width, screen_height);
     lv_display_set_buffers(
@@ -608,6 +1314,12 @@ void lv_api_update_div_text(LvHandler * handler) {
     handler->div_update = true;
 }
 
+void lv_api_update_segment_text(LvHandler * handler) {
+    if (handler == NULL)
+        return;
+    handler->segment_update = true;
+}
+
 void lv_api_update_ts_status(TsInfo * info) {
     if (info == NULL)
         return; 
@@ -709,6 +1421,12 @@ void lv_api_run(LvHandler * handler) {
         handler->div_update = false;
     }
 
+    // Update the displayed segment
+    if (handler->segment_update) {
+        _lv_api_segment_set_text(handler);
+        handler->segment_update = false;
+    }
+
     // Update trigger line
     for (ChartHandlerChannel ch = CHART_HANDLER_CHANNEL_1; ch < CHART_HANDLER_CHANNEL_COUNT; ++ch) {
         if (handler->trigger_update[ch]) {
@@ -729,6 +1447,16 @@ void lv_api_run(LvHandler * handler) {
         }
     }
 
+    // The waveforms would be drawn over the menu which covers the chart
+    const bool menu_hidden = lv_obj_has_flag(handler->menu, LV_OBJ_FLAG_HIDDEN);
+    if (menu_hidden != handler->waveform_layer_enabled)
+        _lv_api_waveform_layer_set_enable(handler, menu_hidden);
+
+    // Fade the persistence and redraw only the rows whose intensity changed
+    persistence_decay();
+    if (persistence_is_changed())
+        waveform_refresh();
+
     // Update loading bar
     if (handler->loading_bar_hide) {
         lv_obj_add_flag(handler->loading_bar, LV_OBJ_FLAG_HIDDEN);
@@ -749,48 +1477,31 @@ void lv_api_run(LvHandler * handler) {
 void lv_api_clear_channel_data(LvHandler * handler, ChartHandlerChannel ch) {
     if (handler == NULL)
         return;
-    memset(handler->channels[ch], LV_CHART_POINT_NONE, CHART_POINT_COUNT * sizeof(int32_t));
+    waveform_clear(ch);
+    persistence_clear(ch);
 }
 
 void lv_api_update_points(
     LvHandler * handler,
     ChartHandlerChannel ch,
-    float * values,
+    const int16_t * values,
+    const int16_t * min_values,
     size_t size)
 {
     if (handler == NULL || values == NULL)
         return;
 
-    const float dt = size / (float)CHART_POINT_COUNT;
-    // const size_t step = dt == 0.f ? 1U : dt;
-    
-    size_t j = 0;
-    float t = 0;
-    for (size_t x = 0; x < CHART_POINT_COUNT; ++x) {
-        // Interpolate
-        // size_t k = j >= (CHART_HANDLER_VALUES_COUNT - 1) ? (CHART_HANDLER_VALUES_COUNT - 1) : (j + step);
-        float val = values[j]; // LERP(values[j], values[k], t);
-        if (val == NAN)
-            val = LV_CHART_POINT_NONE;
-        else {
-            // Convert to screen space
-            val = lv_api_grid_units_to_chart(ch, val);
-        }
-
-        // Copy value
-        handler->channels[ch][x] = val;
-        t += dt;
-        if (t >= 1.0f) {
-            j += t;
-            t = 0.f;
-        }
-    }
+    // Draw one vertical span for each column of the chart, the second channel uses the secondary axis
+    const int32_t range = ch == CHART_HANDLER_CHANNEL_1 ? CHART_AXIS_PRIMARY_Y_MAX_COORD : CHART_AXIS_SECONDARY_Y_MAX_COORD;
+    waveform_draw(ch, values, min_values, size, range);
 
-    lv_chart_refresh(handler->chart);
+    // Accumulate the new waveform into the persistence, the waveform layer already shows it
+    if (persistence_is_enabled())
+        persistence_draw(ch, waveform_get_top(ch), waveform_get_bottom(ch), waveform_get_width());
 }
 
 void lv_api_refresh_chart(LvHandler * handler) {
     if (handler == NULL)
         return;
-    lv_chart_refresh(handler->chart);
+    lv_obj_invalidate(handler->chart);
 }
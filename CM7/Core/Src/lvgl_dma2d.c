@@ -0,0 +1,389 @@
+/**
+ * @file lvgl_dma2d.c
+ * @brief LVGL draw unit which uses the DMA2D for the fills and the images
+ *
+ * @details The plain rectangle fills, the image blits and the alpha blending of
+ * the images are done by the DMA2D directly inside the frame buffers, every other
+ * draw task is left to the software renderer
+ *
+ * The DMA2D cannot reach the DTCM RAM, so only the layers placed in the SDRAM
+ * (the frame buffers) and the images placed in the SDRAM, in the AXI SRAM or in
+ * the flash are handled, the tasks of the other layers are given back to the
+ * software renderer
+ *
+ * @date Oct 16, 2026
+ * @author Antonio Gelain [antonio.gelain@studenti.unitn.it]
+ */
+
+#include "lvgl_dma2d.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "config.h"
+
+/** @brief Identifier of the draw unit, different from the ones of the LVGL draw units */
+#define LV_DMA2D_UNIT_ID (10U)
+
+/** @brief Score of the supported tasks, lower than the one of the software renderer */
+#define LV_DMA2D_PREFERENCE_SCORE (70U)
+
+/** @brief Minimum number of pixels of a task below which the software renderer is faster */
+#define LV_DMA2D_MIN_PIXEL_COUNT (256U)
+
+/** @brief Maximum time of a single transfer in ms */
+#define LV_DMA2D_TIMEOUT (100U)
+
+/**
+ * @brief Type definition for the DMA2D draw unit
+ *
+ * @param base_unit The LVGL draw unit, must be the first field
+ * @param hdma2d A pointer to the DMA2D handler structure
+ */
+typedef struct {
+    lv_draw_unit_t base_unit;
+    DMA2D_HandleTypeDef * hdma2d;
+} LvDma2dUnit;
+
+/**
+ * @brief Check if an address is inside the SDRAM, which is not cacheable
+ *
+ * @param addr The address to check
+ *
+ * @return bool True if the address is inside the SDRAM, false otherwise
+ */
+static inline bool _lv_dma2d_is_sdram(const void * addr) {
+    return (uint32_t)addr >= SDRAM_ADDRESS && (uint32_t)addr < SDRAM_ADDRESS + SDRAM_SIZE;
+}
+
+/**
+ * @brief Check if an address is inside the AXI SRAM, which is cacheable
+ *
+ * @param addr The address to check
+ *
+ * @return bool True if the address is inside the AXI SRAM, false otherwise
+ */
+static inline bool _lv_dma2d_is_axi_sram(const void * addr) {
+    return (uint32_t)addr >= D1_AXISRAM_BASE && (uint32_t)addr < D1_AXISRAM_BASE + AXI_SRAM_SIZE;
+}
+
+/**
+ * @brief Check if a memory area can be read by the DMA2D
+ *
+ * @param addr The start address of the area
+ *
+ * @return bool True if the DMA2D can read the area, false otherwise
+ */
+static bool _lv_dma2d_is_reachable(const void * addr) {
+    return _lv_dma2d_is_sdram(addr) || _lv_dma2d_is_axi_sram(addr) ||
+        ((uint32_t)addr >= FLASH_BANK1_BASE && (uint32_t)addr <= FLASH_END);
+}
+
+/**
+ * @brief Get the DMA2D input color mode of an LVGL color format
+ *
+ * @param cf The LVGL color format
+ * @param mode The DMA2D input color mode
+ *
+ * @return bool True if the color format is supported, false otherwise
+ */
+static bool _lv_dma2d_get_input_mode(lv_color_format_t cf, uint32_t * mode) {
+    switch (cf) {
+        case LV_COLOR_FORMAT_ARGB8888:
+        case LV_COLOR_FORMAT_XRGB8888:
+            *mode = DMA2D_INPUT_ARGB8888;
+            return true;
+        case LV_COLOR_FORMAT_RGB888:
+            *mode = DMA2D_INPUT_RGB888;
+            return true;
+        case LV_COLOR_FORMAT_RGB565:
+            *mode = DMA2D_INPUT_RGB565;
+            return true;
+        case LV_COLOR_FORMAT_A8:
+            *mode = DMA2D_INPUT_A8;
+            return true;
+        default:
+            return false;
+    }
+}
+
+/**
+ * @brief Convert an LVGL color to the 32 bit color used by the DMA2D registers
+ *
+ * @param color The LVGL color
+ * @param opa The alpha of the color
+ *
+ * @return uint32_t The color in ARGB8888 format
+ */
+static inline uint32_t _lv_dma2d_color(lv_color_t color, lv_opa_t opa) {
+    return ((uint32_t)opa << 24U) | ((uint32_t)color.red << 16U) | ((uint32_t)color.green << 8U) | color.blue;
+}
+
+/**
+ * @brief Check if a fill can be done by the DMA2D
+ *
+ * @param dsc The fill descriptor
+ *
+ * @return bool True if the fill is supported, false otherwise
+ */
+static bool _lv_dma2d_is_fill_supported(const lv_draw_fill_dsc_t * dsc) {
+    return dsc->radius == 0 && dsc->grad.dir == LV_GRAD_DIR_NONE && dsc->opa > LV_OPA_MIN;
+}
+
+/**
+ * @brief Check if an image can be drawn by the DMA2D
+ *
+ * @details Only the images stored in memory can be drawn without any transformation,
+ * the A8 images are drawn with the recolor
+ *
+ * @param dsc The image descriptor
+ *
+ * @return bool True if the image is supported, false otherwise
+ */
+static bool _lv_dma2d_is_image_supported(const lv_draw_image_dsc_t * dsc) {
+    if (dsc->opa <= LV_OPA_MIN || dsc->rotation != 0 || dsc->scale_x != LV_SCALE_NONE || dsc->scale_y != LV_SCALE_NONE)
+        return false;
+    if (dsc->blend_mode != LV_BLEND_MODE_NORMAL || dsc->tile || dsc->bitmap_mask_src != NULL)
+        return false;
+    if (lv_image_src_get_type(dsc->src) != LV_IMAGE_SRC_VARIABLE)
+        return false;
+
+    const lv_image_dsc_t * img = dsc->src;
+    uint32_t mode;
+    if (img->data == NULL || !_lv_dma2d_is_reachable(img->data) || !_lv_dma2d_get_input_mode(img->header.cf, &mode))
+        return false;
+    if ((img->header.flags & (LV_IMAGE_FLAGS_PREMULTIPLIED | LV_IMAGE_FLAGS_COMPRESSED)) != 0U)
+        return false;
+    return img->header.cf == LV_COLOR_FORMAT_A8 || dsc->recolor_opa <= LV_OPA_MIN;
+}
+
+/**
+ * @brief Run a single transfer and wait for its completion
+ *
+ * @details The foreground layer (1) and the background layer (0) must be already
+ * configured inside the handler when the mode requires them
+ *
+ * @param hdma2d A pointer to the DMA2D handler structure
+ * @param mode The DMA2D transfer mode
+ * @param src The foreground address or color
+ * @param dst The first pixel of the destination
+ * @param width The width of the area in pixels
+ * @param height The height of the area in pixels
+ * @param dst_offset The number of pixels between the end of a row and the start of the next one
+ */
+static void _lv_dma2d_transfer(
+    DMA2D_HandleTypeDef * hdma2d,
+    uint32_t mode,
+    uint32_t src,
+    void * dst,
+    uint32_t width,
+    uint32_t height,
+    uint32_t dst_offset)
+{
+    hdma2d->Init.Mode = mode;
+    hdma2d->Init.ColorMode = DMA2D_OUTPUT_ARGB8888;
+    hdma2d->Init.OutputOffset = dst_offset;
+    if (HAL_DMA2D_Init(hdma2d) != HAL_OK)
+        return;
+    if (mode != DMA2D_R2M && HAL_DMA2D_ConfigLayer(hdma2d, 1U) != HAL_OK)
+        return;
+
+    HAL_StatusTypeDef status;
+    if (mode == DMA2D_M2M_BLEND || mode == DMA2D_M2M_BLEND_FG) {
+        // The destination is also the background of the blending
+        hdma2d->LayerCfg[0].InputOffset = dst_offset;
+        hdma2d->LayerCfg[0].InputColorMode = DMA2D_INPUT_ARGB8888;
+        hdma2d->LayerCfg[0].AlphaMode = DMA2D_NO_MODIF_ALPHA;
+        hdma2d->LayerCfg[0].InputAlpha = 0xFFU;
+        hdma2d->LayerCfg[0].AlphaInverted = DMA2D_REGULAR_ALPHA;
+        hdma2d->LayerCfg[0].RedBlueSwap = DMA2D_RB_REGULAR;
+        if (HAL_DMA2D_ConfigLayer(hdma2d, 0U) != HAL_OK)
+            return;
+        status = HAL_DMA2D_BlendingStart(hdma2d, src, (uint32_t)dst, (uint32_t)dst, width, height);
+    }
+    else
+        status = HAL_DMA2D_Start(hdma2d, src, (uint32_t)dst, width, height);
+
+    // The CPU stays available to the interrupts while the DMA2D is running
+    if (status == HAL_OK)
+        HAL_DMA2D_PollForTransfer(hdma2d, LV_DMA2D_TIMEOUT);
+}
+
+/**
+ * @brief Fill a rectangle with a single color
+ *
+ * @param unit A pointer to the DMA2D draw unit
+ * @param t The fill task
+ * @param area The area to fill in absolute coordinates
+ */
+static void _lv_dma2d_fill(LvDma2dUnit * unit, lv_draw_task_t * t, const lv_area_t * area) {
+    const lv_draw_fill_dsc_t * dsc = t->draw_dsc;
+    lv_layer_t * layer = unit->base_unit.target_layer;
+
+    void * dst = lv_draw_buf_goto_xy(layer->draw_buf, area->x1 - layer->buf_area.x1, area->y1 - layer->buf_area.y1);
+    const uint32_t w = lv_area_get_width(area);
+    const uint32_t h = lv_area_get_height(area);
+    const uint32_t dst_offset = layer->draw_buf->header.stride / sizeof(uint32_t) - w;
+
+    if (dsc->opa >= LV_OPA_MAX) {
+        _lv_dma2d_transfer(unit->hdma2d, DMA2D_R2M, _lv_dma2d_color(dsc->color, LV_OPA_COVER), dst, w, h, dst_offset);
+        return;
+    }
+
+    // The color is blended as a fixed foreground with the alpha of the fill
+    DMA2D_LayerCfgTypeDef * fg = &unit->hdma2d->LayerCfg[1];
+    fg->InputOffset = 0U;
+    fg->InputColorMode = DMA2D_INPUT_ARGB8888;
+    fg->AlphaMode = DMA2D_REPLACE_ALPHA;
+    fg->InputAlpha = dsc->opa;
+    fg->AlphaInverted = DMA2D_REGULAR_ALPHA;
+    fg->RedBlueSwap = DMA2D_RB_REGULAR;
+    _lv_dma2d_transfer(unit->hdma2d, DMA2D_M2M_BLEND_FG, _lv_dma2d_color(dsc->color, dsc->opa), dst, w, h, dst_offset);
+}
+
+/**
+ * @brief Copy or blend an image
+ *
+ * @param unit A pointer to the DMA2D draw unit
+ * @param t The image task
+ * @param area The area to draw in absolute coordinates
+ */
+static void _lv_dma2d_image(LvDma2dUnit * unit, lv_draw_task_t * t, const lv_area_t * area) {
+    const lv_draw_image_dsc_t * dsc = t->draw_dsc;
+    const lv_image_dsc_t * img = dsc->src;
+    lv_layer_t * layer = unit->base_unit.target_layer;
+
+    uint32_t mode;
+    _lv_dma2d_get_input_mode(img->header.cf, &mode);
+    const uint32_t px_size = lv_color_format_get_size(img->header.cf);
+    const uint32_t stride = img->header.stride != 0U ? img->header.stride : img->header.w * px_size;
+
+    void * dst = lv_draw_buf_goto_xy(layer->draw_buf, area->x1 - layer->buf_area.x1, area->y1 - layer->buf_area.y1);
+    const uint32_t w = lv_area_get_width(area);
+    const uint32_t h = lv_area_get_height(area);
+    const uint32_t dst_offset = layer->draw_buf->header.stride / sizeof(uint32_t) - w;
+
+    // First pixel of the image inside the area
+    const uint8_t * src = img->data + (area->y1 - t->area.y1) * stride + (area->x1 - t->area.x1) * px_size;
+
+    // The images in the AXI SRAM could still be inside the cache
+    if (_lv_dma2d_is_axi_sram(img->data))
+        SCB_CleanDCache_by_Addr((uint32_t *)img->data, img->data_size);
+
+    DMA2D_LayerCfgTypeDef * fg = &unit->hdma2d->LayerCfg[1];
+    fg->InputOffset = stride / px_size - w;
+    fg->InputColorMode = mode;
+    fg->AlphaInverted = DMA2D_REGULAR_ALPHA;
+    fg->RedBlueSwap = DMA2D_RB_REGULAR;
+
+    const bool opaque = img->header.cf != LV_COLOR_FORMAT_ARGB8888 && img->header.cf != LV_COLOR_FORMAT_A8;
+    if (img->header.cf == LV_COLOR_FORMAT_A8) {
+        // Each pixel is the opacity of the recolor
+        fg->AlphaMode = DMA2D_COMBINE_ALPHA;
+        fg->InputAlpha = _lv_dma2d_color(dsc->recolor, dsc->opa);
+    }
+    else if (opaque) {
+        fg->AlphaMode = DMA2D_REPLACE_ALPHA;
+        fg->InputAlpha = dsc->opa;
+    }
+    else {
+        fg->AlphaMode = DMA2D_COMBINE_ALPHA;
+        fg->InputAlpha = dsc->opa;
+    }
+
+    // An opaque image is only converted, without reading the destination
+    const uint32_t transfer = opaque && dsc->opa >= LV_OPA_MAX ? DMA2D_M2M_PFC : DMA2D_M2M_BLEND;
+    _lv_dma2d_transfer(unit->hdma2d, transfer, (uint32_t)src, dst, w, h, dst_offset);
+}
+
+/**
+ * @brief Give the tasks of a layer assigned to the DMA2D back to the software renderer
+ *
+ * @param layer The layer to update
+ */
+static void _lv_dma2d_release_tasks(lv_layer_t * layer) {
+    for (lv_draw_task_t * t = layer->draw_task_head; t != NULL; t = t->next) {
+        if (t->state == LV_DRAW_TASK_STATE_QUEUED && t->preferred_draw_unit_id == LV_DMA2D_UNIT_ID)
+            t->preferred_draw_unit_id = LV_DRAW_UNIT_NONE;
+    }
+}
+
+/**
+ * @brief LVGL callback used to take and execute a task of a layer
+ *
+ * @param draw_unit A pointer to the DMA2D draw unit
+ * @param layer The layer with the tasks to execute
+ *
+ * @return int32_t 1 if a task is executed, LV_DRAW_UNIT_IDLE otherwise
+ */
+static int32_t _lv_dma2d_dispatch(lv_draw_unit_t * draw_unit, lv_layer_t * layer) {
+    LvDma2dUnit * unit = (LvDma2dUnit *)draw_unit;
+
+    // Only the tasks assigned to the DMA2D are taken, the others are left to the software renderer
+    lv_draw_task_t * t = NULL;
+    do {
+        t = lv_draw_get_next_available_task(layer, t, LV_DMA2D_UNIT_ID);
+    } while (t != NULL && t->preferred_draw_unit_id != LV_DMA2D_UNIT_ID);
+    if (t == NULL)
+        return LV_DRAW_UNIT_IDLE;
+
+    if (lv_draw_layer_alloc_buf(layer) == NULL)
+        return LV_DRAW_UNIT_IDLE;
+    if (!_lv_dma2d_is_sdram(layer->draw_buf->data) ||
+        (layer->color_format != LV_COLOR_FORMAT_ARGB8888 && layer->color_format != LV_COLOR_FORMAT_XRGB8888))
+    {
+        _lv_dma2d_release_tasks(layer);
+        return LV_DRAW_UNIT_IDLE;
+    }
+
+    t->state = LV_DRAW_TASK_STATE_IN_PROGRESS;
+    unit->base_unit.target_layer = layer;
+    unit->base_unit.clip_area = &t->clip_area;
+
+    lv_area_t area;
+    if (_lv_area_intersect(&area, &t->area, &t->clip_area)) {
+        if (t->type == LV_DRAW_TASK_TYPE_FILL)
+            _lv_dma2d_fill(unit, t, &area);
+        else
+            _lv_dma2d_image(unit, t, &area);
+    }
+
+    t->state = LV_DRAW_TASK_STATE_READY;
+    lv_draw_dispatch_request();
+    return 1;
+}
+
+/**
+ * @brief LVGL callback used to check if a new task can be executed by the DMA2D
+ *
+ * @param draw_unit A pointer to the DMA2D draw unit
+ * @param task The new task
+ *
+ * @return int32_t Always 0
+ */
+static int32_t _lv_dma2d_evaluate(lv_draw_unit_t * draw_unit, lv_draw_task_t * task) {
+    LV_UNUSED(draw_unit);
+    if (lv_area_get_size(&task->area) < LV_DMA2D_MIN_PIXEL_COUNT)
+        return 0;
+
+    bool supported = false;
+    if (task->type == LV_DRAW_TASK_TYPE_FILL)
+        supported = _lv_dma2d_is_fill_supported(task->draw_dsc);
+    else if (task->type == LV_DRAW_TASK_TYPE_IMAGE)
+        supported = _lv_dma2d_is_image_supported(task->draw_dsc);
+
+    if (supported && task->preference_score > LV_DMA2D_PREFERENCE_SCORE) {
+        task->preference_score = LV_DMA2D_PREFERENCE_SCORE;
+        task->preferred_draw_unit_id = LV_DMA2D_UNIT_ID;
+    }
+    return 0;
+}
+
+void lv_dma2d_init(DMA2D_HandleTypeDef * hdma2d) {
+    if (hdma2d == NULL)
+        return;
+    LvDma2dUnit * unit = lv_draw_create_unit(sizeof(LvDma2dUnit));
+    unit->base_unit.dispatch_cb = _lv_dma2d_dispatch;
+    unit->base_unit.evaluate_cb = _lv_dma2d_evaluate;
+    unit->hdma2d = hdma2d;
+}
@@ -27,12 +27,18 @@
 #include <string.h>
 #include <stdbool.h>
 
+#include "acquisition.h"
 #include "chart_handler.h"
 #include "config.h"
 #include "lcd.h"
 #include "lvgl_api.h"
+#include "persistence.h"
+#include "record.h"
+#include "segments.h"
+#include "shared.h"
 #include "stm32h7xx_hal_adc.h"
 #include "touch_screen.h"
+#include "waveform.h"
 
 /* USER CODE END Includes */
 
@@ -48,6 +54,11 @@
 #define HSEM_ID_0 (0U) /* HW semaphore 0*/
 #endif
 
+// Released by the CM4 at the start of every period of the generated signal
+#ifndef HSEM_ID_1
+#define HSEM_ID_1 (1U) /* HW semaphore 1*/
+#endif
+
 /* USER CODE END PD */
 
 /* Private macro -------------------------------------------------------------*/
@@ -56,9 +67,10 @@
 /* USER CODE END PM */
 
 /* Private variables ---------------------------------------------------------*/
+ADC_HandleTypeDef hadc1;
 ADC_HandleTypeDef hadc2;
 ADC_HandleTypeDef hadc3;
-DMA_HandleTypeDef hdma_adc2;
+DMA_HandleTypeDef hdma_adc1;
 
 CRC_HandleTypeDef hcrc;
 
@@ -70,6 +82,7 @@ I2C_HandleTypeDef hi2c4;
 
 LTDC_HandleTypeDef hltdc;
 
+TIM_HandleTypeDef htim6;
 TIM_HandleTypeDef htim7;
 
 UART_HandleTypeDef huart1;
@@ -85,18 +98,21 @@ static LvHandler lv_handler;
 /* Private function prototypes -----------------------------------------------*/
 void SystemClock_Config(void);
 void PeriphCommonClock_Config(void);
+static void MPU_Config(void);
 static void MX_GPIO_Init(void);
 static void MX_DMA_Init(void);
 static void MX_I2C4_Init(void);
 static void MX_DMA2D_Init(void);
 static void MX_CRC_Init(void);
 static void MX_TIM7_Init(void);
+static void MX_TIM6_Init(void);
 static void MX_DSIHOST_DSI_Init(void);
 static void MX_ADC2_Init(void);
 static void MX_LTDC_Init(void);
 static void MX_USART1_UART_Init(void);
 static void MX_ADC3_Init(void);
 static void MX_FMC_Init(void);
+static void MX_ADC1_Init(void);
 /* USER CODE BEGIN PFP */
 
 /* USER CODE END PFP */
@@ -104,29 +120,6 @@ static void MX_FMC_Init(void);
 /* Private user code ---------------------------------------------------------*/
 /* USER CODE BEGIN 0 */
 
-/**
- * @brief Start the timer used to count microseconds
- */
-void start_channels_conversion(void) {
-    // Restart microseconds timer
-    __HAL_TIM_SET_COUNTER(&htim7, 0U);
-    HAL_TIM_Base_Start(&htim7);
-    // Start ADC conversion
-    HAL_ADC_Start_DMA(&hadc2, (uint32_t *)CHART_CH1_RAW_DATA_ADDRESS, CHART_SAMPLE_COUNT); 
-}
-
-/**
- * @brief Stop the timer used to count microseconds
- *
- * @return uint32_t The timer counter value
- */
-uint32_t stop_channels_conversion(void) {
-    // Stop microseconds timer and ADC conversion
-    HAL_TIM_Base_Stop(&htim7);
-    HAL_ADC_Stop_DMA(&hadc2);
-    return __HAL_TIM_GET_COUNTER(&htim7);
-}
-
 void select_knob_channel(size_t i) {
     ADC_ChannelConfTypeDef config = {
         .Channel = ADC_CHANNEL_0,
@@ -162,8 +155,14 @@ void update_knob_trigger(uint16_t value) {
         return;
     prev_value = value;
 
-    value *= 4U;
-    chart_handler_set_trigger(&lv_handler.chart_handler, CHART_HANDLER_CHANNEL_1, value);
+    // The external sources have no trigger level
+    const ChartHandlerChannel ch = chart_handler_get_trigger_channel(&lv_handler.chart_handler);
+    if (ch >= CHART_HANDLER_CHANNEL_COUNT)
+        return;
+
+    // The knobs are converted at 12 bit
+    value <<= (ADC_RESOLUTION - 12U);
+    chart_handler_set_trigger(&lv_handler.chart_handler, ch, value);
 }
 
 void update_knob_scale(uint16_t value) {
@@ -171,7 +170,7 @@ void update_knob_scale(uint16_t value) {
     static size_t prev_x_index = 6U;
 
     const float scales[] = { 50.f, 100.f, 125.f, 250.f, 500.f, 1000.f, 2000.f, 5000.f };
-    const float x_scales[] = { 10.f, 50.f, 100.f, 500.f, 1000.f, 2000.f, 5000.f, 10000.f, 50000.f, 100000.f };
+    const float x_scales[] = { 1.f, 10.f, 50.f, 100.f, 500.f, 1000.f, 2000.f, 5000.f, 10000.f, 50000.f, 100000.f };
 
     ChartHandlerKnobMode mode = chart_handler_knob_get_mode(&lv_handler.chart_handler);
 
@@ -206,6 +205,9 @@ void update_knob_offset(uint16_t value) {
         return;
     prev_value = value;
 
+    // Keep the same offset range used with the 14 bit samples
+    value <<= (ADC_RESOLUTION - 14U);
+
     ChartHandlerKnobMode mode = chart_handler_knob_get_mode(&lv_handler.chart_handler);
     switch (mode) {
         case CHART_HANDLER_KNOB_VOLTAGE:
@@ -230,10 +232,21 @@ int main(void)
   /* USER CODE BEGIN 1 */
 
   /* USER CODE END 1 */
+
+  /* MPU Configuration--------------------------------------------------------*/
+  MPU_Config();
 /* USER CODE BEGIN Boot_Mode_Sequence_0 */
   int32_t timeout;
 /* USER CODE END Boot_Mode_Sequence_0 */
 
+  /* Enable the CPU Cache */
+
+  /* Enable I-Cache---------------------------------------------------------*/
+  SCB_EnableICache();
+
+  /* Enable D-Cache---------------------------------------------------------*/
+  SCB_EnableDCache();
+
 /* USER CODE BEGIN Boot_Mode_Sequence_1 */
   /* Wait until CPU2 boots and enters in stop mode or timeout*/
   timeout = 0xFFFF;
@@ -292,13 +305,25 @@ Error_Handler();
   MX_USART1_UART_Init();
   MX_ADC3_Init();
   MX_FMC_Init();
+  MX_TIM6_Init();
+  MX_ADC1_Init();
   /* USER CODE BEGIN 2 */
 
   // Clear SRAM used memory before use
   memset((uint32_t *)LCD_FRAME_BUFFER_0_ADDRESS, 0U, LCD_FRAME_BUFFER_0_WIDTH);
   memset((uint32_t *)LCD_FRAME_BUFFER_1_ADDRESS, 0U, LCD_FRAME_BUFFER_1_WIDTH);
-  memset((uint32_t *)CHART_CH1_RAW_DATA_ADDRESS, 0U, CHART_CH1_RAW_DATA_WIDTH);
-  memset((uint32_t *)CHART_CH2_RAW_DATA_ADDRESS, 0U, CHART_CH2_RAW_DATA_WIDTH);
+
+  // Init the deep memory record placed after the frame buffers
+  record_init();
+
+  // Init the persistence placed after the record
+  persistence_init();
+
+  // Init the waveform buffers placed after the persistence
+  waveform_init();
+
+  // Init the segmented memory placed after the waveform buffers
+  segments_init();
 
   // Init LCD display controller
   if (lcd_init(&hdsi, LCD_INITIAL_BRIGHTNESS) != HAL_OK)
@@ -339,13 +364,24 @@ Error_Handler();
   /* USER CODE BEGIN WHILE */
 
   // Calibrate ADC
+  HAL_ADCEx_Calibration_Start(&hadc1, ADC_CALIB_OFFSET_LINEARITY, ADC_SINGLE_ENDED);
   HAL_ADCEx_Calibration_Start(&hadc2, ADC_CALIB_OFFSET_LINEARITY, ADC_SINGLE_ENDED);
   HAL_ADCEx_Calibration_Start(&hadc3, ADC_CALIB_OFFSET_LINEARITY, ADC_SINGLE_ENDED);
   HAL_Delay(10);
 
   // Start oscilloscope channel conversions
-  // BUG: DMA transfert error if using the internal RAM as memory destination
-  start_channels_conversion();
+  if (acquisition_init(&hadc1, &hadc2, &htim6, &lv_handler.chart_handler) != HAL_OK)
+      Error_Handler();
+  // The inputs are at rest at startup, so only the offset between the ADCs is measured
+  if (acquisition_calibrate(ACQUISITION_CALIBRATION_LOW) != HAL_OK)
+      Error_Handler();
+  if (acquisition_start() != HAL_OK)
+      Error_Handler();
+
+  // Get notified by the CM4 at the start of every period of the generated signal
+  HAL_HSEM_ActivateNotification(__HAL_HSEM_SEMID_TO_MASK(HSEM_ID_1));
+  HAL_NVIC_SetPriority(HSEM1_IRQn, 0, 0);
+  HAL_NVIC_EnableIRQ(HSEM1_IRQn);
 
   // Start potenziometers ADC
   HAL_ADC_Start(&hadc3);
@@ -353,12 +389,25 @@ Error_Handler();
   uint32_t timestamp = 0U;
   uint32_t knob_t = 0U;
   size_t knob_i = 0U;
+  uint32_t dropped_count = 0U;
 
   while (1)
   {
     if (HAL_GetTick() - timestamp >= 500U) {
         HAL_GPIO_TogglePin(LED_GREEN_GPIO_Port, LED_GREEN_Pin);
         timestamp = HAL_GetTick();
+
+        // Report blocks lost by the acquisition
+        uint32_t dropped = acquisition_get_dropped_count();
+        if (dropped != dropped_count) {
+            char msg[64] = { 0 };
+            sprintf(msg, "Dropped blocks: %lu\r\n", dropped);
+            HAL_UART_Transmit(&huart1, (uint8_t *)msg, strlen(msg), 30);
+            dropped_count = dropped;
+        }
+
+        // A single acquisition stops the channel on its own
+        HAL_GPIO_WritePin(LED_BLUE_GPIO_Port, LED_BLUE_Pin, chart_handler_is_running(&lv_handler.chart_handler, CHART_HANDLER_CHANNEL_1));
     }
 
     // Read knob values
@@ -481,6 +530,76 @@ void PeriphCommonClock_Config(void)
   }
 }
 
+/**
+  * @brief ADC1 Initialization Function
+  * @param None
+  * @retval None
+  */
+static void MX_ADC1_Init(void)
+{
+
+  /* USER CODE BEGIN ADC1_Init 0 */
+
+  /* USER CODE END ADC1_Init 0 */
+
+  ADC_MultiModeTypeDef multimode = {0};
+  ADC_ChannelConfTypeDef sConfig = {0};
+
+  /* USER CODE BEGIN ADC1_Init 1 */
+
+  /* USER CODE END ADC1_Init 1 */
+
+  /** Common config
+  */
+  hadc1.Instance = ADC1;
+  hadc1.Init.ClockPrescaler = ADC_CLOCK_ASYNC_DIV1;
+  hadc1.Init.Resolution = ADC_RESOLUTION_14B;
+  hadc1.Init.ScanConvMode = ADC_SCAN_DISABLE;
+  hadc1.Init.EOCSelection = ADC_EOC_SEQ_CONV;
+  hadc1.Init.LowPowerAutoWait = DISABLE;
+  hadc1.Init.ContinuousConvMode = DISABLE;
+  hadc1.Init.NbrOfConversion = 1;
+  hadc1.Init.DiscontinuousConvMode = DISABLE;
+  hadc1.Init.ExternalTrigConv = ADC_EXTERNALTRIG_T6_TRGO;
+  hadc1.Init.ExternalTrigConvEdge = ADC_EXTERNALTRIGCONVEDGE_RISING;
+  hadc1.Init.ConversionDataManagement = ADC_CONVERSIONDATA_DMA_CIRCULAR;
+  hadc1.Init.Overrun = ADC_OVR_DATA_PRESERVED;
+  hadc1.Init.LeftBitShift = ADC_LEFTBITSHIFT_NONE;
+  hadc1.Init.OversamplingMode = DISABLE;
+  if (HAL_ADC_Init(&hadc1) != HAL_OK)
+  {
+    Error_Handler();
+  }
+
+  /** Configure the ADC multi-mode
+  */
+  multimode.Mode = ADC_DUALMODE_REGSIMULT;
+  multimode.DualModeData = ADC_DUALMODEDATAFORMAT_32_10_BITS;
+  multimode.TwoSamplingDelay = ADC_TWOSAMPLINGDELAY_1CYCLE;
+  if (HAL_ADCEx_MultiModeConfigChannel(&hadc1, &multimode) != HAL_OK)
+  {
+    Error_Handler();
+  }
+
+  /** Configure Regular Channel
+  */
+  sConfig.Channel = ADC_CHANNEL_0;
+  sConfig.Rank = ADC_REGULAR_RANK_1;
+  sConfig.SamplingTime = ADC_SAMPLETIME_8CYCLES_5;
+  sConfig.SingleDiff = ADC_SINGLE_ENDED;
+  sConfig.OffsetNumber = ADC_OFFSET_NONE;
+  sConfig.Offset = 0;
+  sConfig.OffsetSignedSaturation = DISABLE;
+  if (HAL_ADC_ConfigChannel(&hadc1, &sConfig) != HAL_OK)
+  {
+    Error_Handler();
+  }
+  /* USER CODE BEGIN ADC1_Init 2 */
+
+  /* USER CODE END ADC1_Init 2 */
+
+}
+
 /**
   * @brief ADC2 Initialization Function
   * @param None
@@ -507,12 +626,10 @@ static void MX_ADC2_Init(void)
   hadc2.Init.ScanConvMode = ADC_SCAN_DISABLE;
   hadc2.Init.EOCSelection = ADC_EOC_SEQ_CONV;
   hadc2.Init.LowPowerAutoWait = DISABLE;
-  hadc2.Init.ContinuousConvMode = ENABLE;
+  hadc2.Init.ContinuousConvMode = DISABLE;
   hadc2.Init.NbrOfConversion = 1;
   hadc2.Init.DiscontinuousConvMode = DISABLE;
-  hadc2.Init.ExternalTrigConv = ADC_SOFTWARE_START;
-  hadc2.Init.ExternalTrigConvEdge = ADC_EXTERNALTRIGCONVEDGE_NONE;
-  hadc2.Init.ConversionDataManagement = ADC_CONVERSIONDATA_DMA_CIRCULAR;
+  hadc2.Init.ConversionDataManagement = ADC_CONVERSIONDATA_DR;
   hadc2.Init.Overrun = ADC_OVR_DATA_PRESERVED;
   hadc2.Init.LeftBitShift = ADC_LEFTBITSHIFT_NONE;
   hadc2.Init.OversamplingMode = DISABLE;
@@ -523,7 +640,7 @@ static void MX_ADC2_Init(void)
 
   /** Configure Regular Channel
   */
-  sConfig.Channel = ADC_CHANNEL_0;
+  sConfig.Channel = ADC_CHANNEL_1;
   sConfig.Rank = ADC_REGULAR_RANK_1;
   sConfig.SamplingTime = ADC_SAMPLETIME_8CYCLES_5;
   sConfig.SingleDiff = ADC_SINGLE_ENDED;
@@ -908,6 +1025,44 @@ static void MX_LTDC_Init(void)
 
 }
 
+/**
+  * @brief TIM6 Initialization Function
+  * @param None
+  * @retval None
+  */
+static void MX_TIM6_Init(void)
+{
+
+  /* USER CODE BEGIN TIM6_Init 0 */
+
+  /* USER CODE END TIM6_Init 0 */
+
+  TIM_MasterConfigTypeDef sMasterConfig = {0};
+
+  /* USER CODE BEGIN TIM6_Init 1 */
+
+  /* USER CODE END TIM6_Init 1 */
+  htim6.Instance = TIM6;
+  htim6.Init.Prescaler = 0;
+  htim6.Init.CounterMode = TIM_COUNTERMODE_UP;
+  htim6.Init.Period = 199;
+  htim6.Init.AutoReloadPreload = TIM_AUTORELOAD_PRELOAD_ENABLE;
+  if (HAL_TIM_Base_Init(&htim6) != HAL_OK)
+  {
+    Error_Handler();
+  }
+  sMasterConfig.MasterOutputTrigger = TIM_TRGO_UPDATE;
+  sMasterConfig.MasterSlaveMode = TIM_MASTERSLAVEMODE_DISABLE;
+  if (HAL_TIMEx_MasterConfigSynchronization(&htim6, &sMasterConfig) != HAL_OK)
+  {
+    Error_Handler();
+  }
+  /* USER CODE BEGIN TIM6_Init 2 */
+
+  /* USER CODE END TIM6_Init 2 */
+
+}
+
 /**
   * @brief TIM7 Initialization Function
   * @param None
@@ -1243,6 +1398,14 @@ static void MX_GPIO_Init(void)
 /* USER CODE BEGIN 4 */
 
 void HAL_GPIO_EXTI_Callback(uint16_t pin) {
+    // The external trigger events are timestamped as soon as possible
+    if (pin == EXTERNAL_TRIGGER_Pin &&
+        chart_handler_get_trigger_source(&lv_handler.chart_handler) == CHART_HANDLER_TRIGGER_SOURCE_EXTERNAL)
+    {
+        acquisition_add_trigger_event();
+        return;
+    }
+
     // Lock to avoid multiple interrupts during operations
     static bool lock = false;
     if (lock)
@@ -1316,23 +1479,27 @@ void HAL_GPIO_EXTI_Callback(uint16_t pin) {
     lock = false;
 }
 
+void HAL_HSEM_FreeCallback(uint32_t mask) {
+    if ((mask & __HAL_HSEM_SEMID_TO_MASK(HSEM_ID_1)) == 0U)
+        return;
+
+    // The notification is disabled every time it is received
+    HAL_HSEM_ActivateNotification(__HAL_HSEM_SEMID_TO_MASK(HSEM_ID_1));
+    if (chart_handler_get_trigger_source(&lv_handler.chart_handler) == CHART_HANDLER_TRIGGER_SOURCE_GENERATOR)
+        acquisition_add_trigger_event();
+}
+
 void HAL_ADC_ErrorCallback(ADC_HandleTypeDef * hadc) {
     UNUSED(hadc);
     HAL_UART_Transmit(&huart1, (uint8_t *)"ADC DMA Error\r\n", 15U, 30);
 }
 
-void HAL_ADC_ConvCpltCallback(ADC_HandleTypeDef * hadc) { 
-    if (hadc->Instance == hadc2.Instance) {
-        // Stop microseconds timer and get counter value
-        uint32_t dt = stop_channels_conversion();
-        if (dt == 0U)
-            dt = 1U;
-
-        chart_handler_update(&lv_handler.chart_handler, dt);
+void HAL_ADC_ConvHalfCpltCallback(ADC_HandleTypeDef * hadc) {
+    acquisition_half_complete_callback(hadc);
+}
 
-        // Restart timer
-        start_channels_conversion();
-    }
+void HAL_ADC_ConvCpltCallback(ADC_HandleTypeDef * hadc) { 
+    acquisition_complete_callback(hadc);
 }
 
 void print(char * msg, size_t len) {
@@ -1341,6 +1508,43 @@ void print(char * msg, size_t len) {
 
 /* USER CODE END 4 */
 
+/* MPU Configuration */
+
+void MPU_Config(void)
+{
+  MPU_Region_InitTypeDef MPU_InitStruct = {0};
+
+  /* Disables the MPU */
+  HAL_MPU_Disable();
+
+  /** Initializes and configures the Region and the memory to be protected
+  */
+  MPU_InitStruct.Enable = MPU_REGION_ENABLE;
+  MPU_InitStruct.Number = MPU_REGION_NUMBER0;
+  MPU_InitStruct.BaseAddress = 0xD0000000;
+  MPU_InitStruct.Size = MPU_REGION_SIZE_32MB;
+  MPU_InitStruct.SubRegionDisable = 0x0;
+  MPU_InitStruct.TypeExtField = MPU_TEX_LEVEL1;
+  MPU_InitStruct.AccessPermission = MPU_REGION_FULL_ACCESS;
+  MPU_InitStruct.DisableExec = MPU_INSTRUCTION_ACCESS_DISABLE;
+  MPU_InitStruct.IsShareable = MPU_ACCESS_NOT_SHAREABLE;
+  MPU_InitStruct.IsCacheable = MPU_ACCESS_NOT_CACHEABLE;
+  MPU_InitStruct.IsBufferable = MPU_ACCESS_NOT_BUFFERABLE;
+
+  HAL_MPU_ConfigRegion(&MPU_InitStruct);
+
+  /** Initializes and configures the Region and the memory to be protected
+  */
+  MPU_InitStruct.Number = MPU_REGION_NUMBER1;
+  MPU_InitStruct.BaseAddress = SHARED_RAM_ADDRESS;
+  MPU_InitStruct.Size = MPU_REGION_SIZE_64KB;
+
+  HAL_MPU_ConfigRegion(&MPU_InitStruct);
+  /* Enables the MPU */
+  HAL_MPU_Enable(MPU_PRIVILEGED_DEFAULT);
+
+}
+
 /**
   * @brief  This function is executed in case of error occurrence.
   * @retval None
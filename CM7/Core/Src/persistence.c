@@ -0,0 +1,234 @@
+/**
+ * @file persistence.c
+ * @brief Persistence of the displayed waveforms
+ *
+ * @details Every displayed waveform is drawn into an intensity buffer as large as
+ * the chart which fades over time, so that the intermittent events stay visible
+ * after the chart is updated with the following waveforms
+ * The rows of each column that were drawn since the column faded out are tracked,
+ * so that only the rows of their union are faded and redrawn on the display instead of the whole area
+ *
+ * @date Oct 16, 2026
+ * @author Antonio Gelain [antonio.gelain@studenti.unitn.it]
+ */
+
+#include "persistence.h"
+
+#include <string.h>
+
+#include "config.h"
+
+// Intensity buffers of both channels, one after the other
+static uint8_t * const persistence_data = (uint8_t *)CHART_PERSISTENCE_ADDRESS;
+
+struct {
+    size_t width;
+    size_t height;
+    uint32_t decay_time; // in ms
+
+    // Time of the last decay and intensity not yet subtracted, multiplied by the decay time
+    uint32_t last_tick;
+    uint64_t fade;
+
+    // Rows of each column which can have an intensity, highest intensity left in the column
+    // and union of the rows of every column
+    int16_t top[LCD_WIDTH];
+    int16_t bottom[LCD_WIDTH];
+    uint8_t intensity[LCD_WIDTH];
+    int16_t first_row;
+    int16_t last_row;
+
+    // Rows of each column and union of the rows changed since the last reset of the changes
+    int16_t changed_top[LCD_WIDTH];
+    int16_t changed_bottom[LCD_WIDTH];
+    int16_t changed_first_row;
+    int16_t changed_last_row;
+} hper;
+
+/**
+ * @brief Mark some rows of a single column as changed
+ *
+ * @param x The column to update
+ * @param top The first changed row
+ * @param bottom The last changed row
+ */
+static void _persistence_mark_changed(size_t x, int16_t top, int16_t bottom) {
+    if (hper.changed_top[x] == PERSISTENCE_NO_ROW || top < hper.changed_top[x])
+        hper.changed_top[x] = top;
+    if (bottom > hper.changed_bottom[x])
+        hper.changed_bottom[x] = bottom;
+    if (hper.changed_first_row == PERSISTENCE_NO_ROW || top < hper.changed_first_row)
+        hper.changed_first_row = top;
+    if (bottom > hper.changed_last_row)
+        hper.changed_last_row = bottom;
+}
+
+/**
+ * @brief Clear the intensity buffers of both channels and mark the cleared rows as changed
+ */
+static void _persistence_reset(void) {
+    for (size_t x = 0U; x < LCD_WIDTH; ++x) {
+        if (hper.top[x] != PERSISTENCE_NO_ROW)
+            _persistence_mark_changed(x, hper.top[x], hper.bottom[x]);
+        hper.top[x] = hper.bottom[x] = PERSISTENCE_NO_ROW;
+        hper.intensity[x] = 0U;
+    }
+    hper.first_row = hper.last_row = PERSISTENCE_NO_ROW;
+    memset(persistence_data, 0U, CHART_PERSISTENCE_WIDTH);
+}
+
+void persistence_init(void) {
+    hper.width = LCD_WIDTH;
+    hper.height = CHART_HEIGHT;
+    hper.decay_time = 0U;
+    hper.last_tick = HAL_GetTick();
+    hper.fade = 0U;
+    for (size_t x = 0U; x < LCD_WIDTH; ++x) {
+        hper.top[x] = hper.bottom[x] = PERSISTENCE_NO_ROW;
+        hper.intensity[x] = 0U;
+    }
+    hper.first_row = hper.last_row = PERSISTENCE_NO_ROW;
+    persistence_reset_changes();
+    memset(persistence_data, 0U, CHART_PERSISTENCE_WIDTH);
+}
+
+HAL_StatusTypeDef persistence_set_size(size_t width, size_t height) {
+    if (width == 0U || height == 0U || width * height > CHART_PERSISTENCE_CHANNEL_WIDTH)
+        return HAL_ERROR;
+    _persistence_reset();
+    hper.width = width;
+    hper.height = height;
+    return HAL_OK;
+}
+
+uint8_t * persistence_get_buffer(ChartHandlerChannel ch) {
+    return &persistence_data[ch * CHART_PERSISTENCE_CHANNEL_WIDTH];
+}
+
+bool persistence_is_enabled(void) {
+    return hper.decay_time != 0U;
+}
+
+uint32_t persistence_get_decay_time(void) {
+    return hper.decay_time;
+}
+
+void persistence_set_decay_time(uint32_t decay_time) {
+    hper.decay_time = decay_time;
+    hper.last_tick = HAL_GetTick();
+    hper.fade = 0U;
+    _persistence_reset();
+}
+
+void persistence_clear(ChartHandlerChannel ch) {
+    if (ch >= CHART_HANDLER_CHANNEL_COUNT)
+        return;
+    memset(persistence_get_buffer(ch), 0U, CHART_PERSISTENCE_CHANNEL_WIDTH);
+
+    // The rows are still kept since the other channel can have an intensity inside them
+    for (size_t x = 0U; x < hper.width; ++x) {
+        if (hper.top[x] != PERSISTENCE_NO_ROW)
+            _persistence_mark_changed(x, hper.top[x], hper.bottom[x]);
+    }
+}
+
+void persistence_draw(ChartHandlerChannel ch, const int16_t * top, const int16_t * bottom, size_t count) {
+    if (!persistence_is_enabled() || ch >= CHART_HANDLER_CHANNEL_COUNT || top == NULL || bottom == NULL)
+        return;
+    uint8_t * buffer = persistence_get_buffer(ch);
+
+    const size_t width = count < hper.width ? count : hper.width;
+    for (size_t x = 0U; x < width; ++x) {
+        if (top[x] < 0 || bottom[x] < top[x])
+            continue;
+        const int16_t last = bottom[x] < (int32_t)hper.height ? bottom[x] : (int16_t)(hper.height - 1U);
+        for (int32_t row = top[x]; row <= last; ++row)
+            buffer[row * hper.width + x] = PERSISTENCE_MAX_INTENSITY;
+
+        // The drawn rows are not changed on the display since they are covered by the waveform
+        if (hper.top[x] == PERSISTENCE_NO_ROW || top[x] < hper.top[x])
+            hper.top[x] = top[x];
+        if (last > hper.bottom[x])
+            hper.bottom[x] = last;
+        hper.intensity[x] = PERSISTENCE_MAX_INTENSITY;
+        if (hper.first_row == PERSISTENCE_NO_ROW || top[x] < hper.first_row)
+            hper.first_row = top[x];
+        if (last > hper.last_row)
+            hper.last_row = last;
+    }
+}
+
+bool persistence_decay(void) {
+    const uint32_t tick = HAL_GetTick();
+    const uint32_t elapsed = tick - hper.last_tick;
+    hper.last_tick = tick;
+    if (hper.decay_time == 0U || hper.decay_time == PERSISTENCE_INFINITE)
+        return false;
+
+    // The intensity fades linearly from the maximum to 0 in the decay time,
+    // the smaller steps are accumulated so that every fade changes the displayed level
+    hper.fade += (uint64_t)elapsed * PERSISTENCE_MAX_INTENSITY;
+    const uint64_t step = hper.fade / hper.decay_time;
+    if (step < PERSISTENCE_MIN_FADE)
+        return false;
+    hper.fade %= hper.decay_time;
+    if (hper.first_row == PERSISTENCE_NO_ROW)
+        return false;
+    const uint8_t sub = step >= PERSISTENCE_MAX_INTENSITY ? PERSISTENCE_MAX_INTENSITY : (uint8_t)step;
+
+    // Four pixels are faded at once with a saturating subtraction, only the rows
+    // drawn since the columns faded out can have an intensity
+    // The rows are contiguous and the other pixels of the first and last word are already 0
+    const uint32_t sub_word = sub * 0x01010101U;
+    const size_t first = (hper.first_row * hper.width) / sizeof(uint32_t);
+    const size_t last = ((hper.last_row + 1U) * hper.width + sizeof(uint32_t) - 1U) / sizeof(uint32_t);
+    for (size_t ch = 0U; ch < CHART_HANDLER_CHANNEL_COUNT; ++ch) {
+        uint32_t * words = (uint32_t *)persistence_get_buffer(ch);
+        for (size_t i = first; i < last; ++i)
+            words[i] = __UQSUB8(words[i], sub_word);
+    }
+
+    // The columns that faded out are forgotten
+    hper.first_row = hper.last_row = PERSISTENCE_NO_ROW;
+    for (size_t x = 0U; x < hper.width; ++x) {
+        if (hper.top[x] == PERSISTENCE_NO_ROW)
+            continue;
+        _persistence_mark_changed(x, hper.top[x], hper.bottom[x]);
+
+        hper.intensity[x] = hper.intensity[x] > sub ? hper.intensity[x] - sub : 0U;
+        if (hper.intensity[x] == 0U) {
+            hper.top[x] = hper.bottom[x] = PERSISTENCE_NO_ROW;
+            continue;
+        }
+        if (hper.first_row == PERSISTENCE_NO_ROW || hper.top[x] < hper.first_row)
+            hper.first_row = hper.top[x];
+        if (hper.bottom[x] > hper.last_row)
+            hper.last_row = hper.bottom[x];
+    }
+    return true;
+}
+
+bool persistence_is_changed(void) {
+    return hper.changed_first_row != PERSISTENCE_NO_ROW;
+}
+
+const int16_t * persistence_get_changed_top(void) {
+    return hper.changed_top;
+}
+
+const int16_t * persistence_get_changed_bottom(void) {
+    return hper.changed_bottom;
+}
+
+void persistence_get_changed_rows(int16_t * first, int16_t * last) {
+    if (first != NULL)
+        *first = hper.changed_first_row;
+    if (last != NULL)
+        *last = hper.changed_last_row;
+}
+
+void persistence_reset_changes(void) {
+    for (size_t x = 0U; x < LCD_WIDTH; ++x)
+        hper.changed_top[x] = hper.changed_bottom[x] = PERSISTENCE_NO_ROW;
+    hper.changed_first_row = hper.changed_last_row = PERSISTENCE_NO_ROW;
+}
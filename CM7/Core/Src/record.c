@@ -0,0 +1,174 @@
+/**
+ * @file record.c
+ * @brief Deep memory record of the acquired samples
+ *
+ * @details Every acquired block is copied into a circular buffer placed in the SDRAM
+ * which keeps the last samples of both channels at full rate, so that the signal
+ * can still be zoomed and scrolled after the channels are stopped
+ *
+ * @date Oct 16, 2026
+ * @author Antonio Gelain [antonio.gelain@studenti.unitn.it]
+ */
+
+#include "record.h"
+
+#include <string.h>
+
+#include "config.h"
+
+// Samples written in the same format of the blocks (interleaved if both channels are acquired)
+static volatile uint16_t * const record_data = (uint16_t *)CHART_RECORD_ADDRESS;
+
+struct {
+    size_t length;
+    size_t stride;
+    float time_per_sample; // in us
+
+    // Index of the next sample to write and number of valid samples
+    size_t head;
+    size_t count;
+    volatile bool frozen;
+} hrec;
+
+/** @brief Discard all the recorded samples */
+static void _record_clear(void) {
+    hrec.head = 0U;
+    hrec.count = 0U;
+}
+
+/**
+ * @brief Prevent the blocks from being written while the record is changed
+ *
+ * @details The blocks are written from the PendSV handler, which is masked
+ * together with every other interrupt with the same priority
+ *
+ * @return uint32_t The previous mask to restore with _record_unlock
+ */
+static inline uint32_t _record_lock(void) {
+    const uint32_t basepri = __get_BASEPRI();
+    __set_BASEPRI_MAX(NVIC_GetPriority(PendSV_IRQn) << (8U - __NVIC_PRIO_BITS));
+    __ISB();
+    return basepri;
+}
+
+/**
+ * @brief Allow the blocks to be written again
+ *
+ * @param basepri The mask returned by _record_lock
+ */
+static inline void _record_unlock(uint32_t basepri) {
+    __set_BASEPRI(basepri);
+}
+
+void record_init(void) {
+    hrec.length = CHART_RECORD_DEFAULT_SAMPLE_COUNT;
+    hrec.stride = CHART_RAW_DATA_STRIDE;
+    hrec.time_per_sample = 0.f;
+    hrec.frozen = false;
+    _record_clear();
+}
+
+size_t record_get_length(void) {
+    return hrec.length;
+}
+
+HAL_StatusTypeDef record_set_length(size_t length) {
+    if (length != 0U && (length < CHART_RECORD_MIN_SAMPLE_COUNT || length > CHART_RECORD_MAX_SAMPLE_COUNT))
+        return HAL_ERROR;
+    const uint32_t basepri = _record_lock();
+    hrec.length = length;
+    _record_clear();
+    _record_unlock(basepri);
+    return HAL_OK;
+}
+
+void record_reset(void) {
+    const uint32_t basepri = _record_lock();
+    if (!hrec.frozen)
+        _record_clear();
+    _record_unlock(basepri);
+}
+
+bool record_is_frozen(void) {
+    return hrec.frozen;
+}
+
+void record_set_frozen(bool frozen) {
+    const uint32_t basepri = _record_lock();
+    if (!frozen)
+        _record_clear();
+    hrec.frozen = frozen;
+    _record_unlock(basepri);
+}
+
+size_t record_get_count(void) {
+    return hrec.count;
+}
+
+float record_get_time_per_sample(void) {
+    return hrec.time_per_sample;
+}
+
+void record_write(const ChartHandlerBlock * block) {
+    if (block == NULL || block->count == 0U || hrec.length == 0U || hrec.frozen)
+        return;
+
+    // The samples of different blocks must have the same layout
+    if (hrec.count == 0U || block->stride != hrec.stride) {
+        _record_clear();
+        hrec.stride = block->stride;
+    }
+    hrec.time_per_sample = block->time_per_sample;
+
+    // The samples of both channels are copied at once, split the copy where the buffer wraps around
+    const volatile uint16_t * src = block->raw[CHART_HANDLER_CHANNEL_1];
+    size_t count = block->count;
+    while (count > 0U) {
+        size_t len = hrec.length - hrec.head;
+        if (len > count)
+            len = count;
+        memcpy(
+            (void *)&record_data[hrec.head * hrec.stride],
+            (const void *)src,
+            len * hrec.stride * sizeof(uint16_t)
+        );
+        src += len * hrec.stride;
+        count -= len;
+
+        hrec.head = (hrec.head + len) % hrec.length;
+        hrec.count += len;
+        if (hrec.count > hrec.length)
+            hrec.count = hrec.length;
+    }
+}
+
+size_t record_get_window(size_t start, size_t count, ChartHandlerBlock * blocks) {
+    if (blocks == NULL || start >= hrec.count || count == 0U)
+        return 0U;
+    if (count > hrec.count - start)
+        count = hrec.count - start;
+
+    // Position of the first sample of the window inside the circular buffer
+    const size_t oldest = (hrec.head + hrec.length - hrec.count) % hrec.length;
+    size_t index = (oldest + start) % hrec.length;
+
+    size_t n = 0U;
+    while (count > 0U && n < RECORD_WINDOW_BLOCK_COUNT) {
+        size_t len = hrec.length - index;
+        if (len > count)
+            len = count;
+
+        blocks[n].raw[CHART_HANDLER_CHANNEL_1] = &record_data[index * hrec.stride];
+        blocks[n].raw[CHART_HANDLER_CHANNEL_2] = &record_data[index * hrec.stride + 1U];
+        blocks[n].stride = hrec.stride;
+        blocks[n].count = len;
+        blocks[n].time_per_sample = hrec.time_per_sample;
+        blocks[n].crossing[CHART_HANDLER_CHANNEL_1] = true;
+        blocks[n].crossing[CHART_HANDLER_CHANNEL_2] = true;
+        ++n;
+
+        count -= len;
+        index = 0U;
+    }
+    return n;
+}
@@ -0,0 +1,77 @@
+/**
+ * @file segments.c
+ * @brief Segmented memory of the triggered frames
+ *
+ * @details In segmented mode every triggered frame is saved into its own segment of
+ * the SDRAM as soon as it is complete and the trigger is armed again right away, so
+ * bursts of events close together are captured without waiting for the display
+ * The channels are stopped once every segment is filled
+ *
+ * @date Oct 16, 2026
+ * @author Antonio Gelain [antonio.gelain@studenti.unitn.it]
+ */
+
+#include "segments.h"
+
+#include "config.h"
+
+// Segments of both channels, one channel after the other
+static Segment * const segments_data = (Segment *)CHART_SEGMENTS_ADDRESS;
+
+struct {
+    size_t length;
+    size_t count[CHART_HANDLER_CHANNEL_COUNT];
+} hseg;
+
+void segments_init(void) {
+    hseg.length = 0U;
+    for (size_t ch = 0U; ch < CHART_HANDLER_CHANNEL_COUNT; ++ch)
+        hseg.count[ch] = 0U;
+}
+
+size_t segments_get_length(void) {
+    return hseg.length;
+}
+
+HAL_StatusTypeDef segments_set_length(size_t length) {
+    if (length > CHART_SEGMENTS_MAX_COUNT)
+        return HAL_ERROR;
+    hseg.length = length;
+    for (size_t ch = 0U; ch < CHART_HANDLER_CHANNEL_COUNT; ++ch)
+        hseg.count[ch] = 0U;
+    return HAL_OK;
+}
+
+bool segments_is_enabled(void) {
+    return hseg.length != 0U;
+}
+
+void segments_reset(ChartHandlerChannel ch) {
+    if (ch >= CHART_HANDLER_CHANNEL_COUNT)
+        return;
+    hseg.count[ch] = 0U;
+}
+
+size_t segments_get_count(ChartHandlerChannel ch) {
+    if (ch >= CHART_HANDLER_CHANNEL_COUNT)
+        return 0U;
+    return hseg.count[ch];
+}
+
+bool segments_is_full(ChartHandlerChannel ch) {
+    if (ch >= CHART_HANDLER_CHANNEL_COUNT)
+        return true;
+    return hseg.count[ch] >= hseg.length;
+}
+
+Segment * segments_push(ChartHandlerChannel ch) {
+    if (segments_is_full(ch))
+        return NULL;
+    return &segments_data[ch * CHART_SEGMENTS_MAX_COUNT + hseg.count[ch]++];
+}
+
+const Segment * segments_get(ChartHandlerChannel ch, size_t index) {
+    if (ch >= CHART_HANDLER_CHANNEL_COUNT || index >= hseg.count[ch])
+        return NULL;
+    return &segments_data[ch * CHART_SEGMENTS_MAX_COUNT + index];
+}
@@ -0,0 +1,301 @@
+/**
+ * @file waveform.c
+ * @brief Rasterization of the displayed waveforms
+ *
+ * @details Every waveform is drawn as a single vertical span for each column of the
+ * chart into the frame buffer of the LTDC foreground layer, which is transparent
+ * everywhere else, so the cost of a new waveform depends on the width of the chart
+ * and not on the number of values
+ * Only the pixels of the previous and of the new spans are updated, the spans of
+ * the other channel are kept since a pixel is covered by a channel only if it is
+ * inside the span of the same column
+ *
+ * The frame buffer is in L8 format, each pixel is an index of a palette which has
+ * an entry for the color of each channel and an entry for each intensity level of
+ * the persistence of each channel, the transparent entry is removed with the color
+ * keying of the LTDC
+ *
+ * @date Oct 16, 2026
+ * @author Antonio Gelain [antonio.gelain@studenti.unitn.it]
+ */
+
+#include "waveform.h"
+
+#include <string.h>
+
+#include "config.h"
+#include "persistence.h"
+
+/** @brief Number of fractional bits of the position of a column between two values */
+#define WAVEFORM_FRACTION_BITS (8U)
+
+/** @brief Shift from the persistence intensity to its level */
+#define WAVEFORM_PERSISTENCE_SHIFT (8U - WAVEFORM_PERSISTENCE_LEVEL_BITS)
+
+// Frame buffer of the foreground layer
+static uint8_t * const waveform_data = (uint8_t *)CHART_WAVEFORM_ADDRESS;
+
+struct {
+    size_t width;
+    size_t height;
+    uint32_t palette[WAVEFORM_PALETTE_SIZE];
+
+    // Span drawn on each column
+    int16_t top[CHART_HANDLER_CHANNEL_COUNT][LCD_WIDTH];
+    int16_t bottom[CHART_HANDLER_CHANNEL_COUNT][LCD_WIDTH];
+} hwave;
+
+/**
+ * @brief Forget the spans of every column and clear the frame buffer
+ */
+static void _waveform_reset(void) {
+    for (size_t ch = 0U; ch < CHART_HANDLER_CHANNEL_COUNT; ++ch) {
+        for (size_t x = 0U; x < LCD_WIDTH; ++x)
+            hwave.top[ch][x] = hwave.bottom[ch][x] = WAVEFORM_NO_SPAN;
+    }
+    memset(waveform_data, WAVEFORM_INDEX_TRANSPARENT, CHART_WAVEFORM_WIDTH);
+}
+
+/**
+ * @brief Get a palette color which is not removed by the color keying
+ *
+ * @param color The color in RGB888 format
+ *
+ * @return uint32_t The same color or the nearest one if it matches the transparent color
+ */
+static inline uint32_t _waveform_opaque(uint32_t color) {
+    return color == WAVEFORM_TRANSPARENT ? (color ^ 0x000001U) : color;
+}
+
+/**
+ * @brief Get the palette index of a single pixel
+ *
+ * @details The last channel whose span covers the pixel is drawn over the others,
+ * otherwise the channel with the highest persistence intensity is drawn
+ *
+ * @param x The column of the pixel
+ * @param row The row of the pixel
+ *
+ * @return uint8_t The palette index
+ */
+static inline uint8_t _waveform_pixel(size_t x, int32_t row) {
+    for (size_t ch = CHART_HANDLER_CHANNEL_COUNT; ch-- > 0U; ) {
+        if (hwave.top[ch][x] != WAVEFORM_NO_SPAN && row >= hwave.top[ch][x] && row <= hwave.bottom[ch][x])
+            return WAVEFORM_INDEX_CHANNEL + ch;
+    }
+    if (!persistence_is_enabled())
+        return WAVEFORM_INDEX_TRANSPARENT;
+
+    uint8_t index = WAVEFORM_INDEX_TRANSPARENT;
+    uint8_t max_level = 0U;
+    for (size_t ch = 0U; ch < CHART_HANDLER_CHANNEL_COUNT; ++ch) {
+        const uint8_t level = persistence_get_buffer(ch)[row * hwave.width + x] >> WAVEFORM_PERSISTENCE_SHIFT;
+        if (level > max_level) {
+            max_level = level;
+            index = WAVEFORM_INDEX_PERSISTENCE + ch * WAVEFORM_PERSISTENCE_LEVEL_COUNT + level;
+        }
+    }
+    return index;
+}
+
+/**
+ * @brief Convert a vertical coordinate to a row of the area
+ *
+ * @param value The vertical coordinate
+ * @param range The coordinate of the top of the area
+ *
+ * @return int32_t The row starting from the top of the area, can be outside of the area
+ */
+static inline int32_t _waveform_to_row(int32_t value, int32_t range) {
+    const int32_t last = (int32_t)hwave.height - 1;
+    return last - (value * last) / range;
+}
+
+/**
+ * @brief Update the pixels of a part of a column with the spans of every channel
+ *
+ * @param x The column to update
+ * @param first The first row to update
+ * @param last The last row to update
+ */
+static void _waveform_compose(size_t x, int32_t first, int32_t last) {
+    for (int32_t row = first; row <= last; ++row)
+        waveform_data[row * hwave.width + x] = _waveform_pixel(x, row);
+}
+
+/**
+ * @brief Replace the span of a single column of a channel
+ *
+ * @param ch The channel to update
+ * @param x The column to update
+ * @param top The first row of the new span, WAVEFORM_NO_SPAN to leave the column empty
+ * @param bottom The last row of the new span
+ */
+static void _waveform_set_span(ChartHandlerChannel ch, size_t x, int16_t top, int16_t bottom) {
+    const int16_t prev_top = hwave.top[ch][x];
+    const int16_t prev_bottom = hwave.bottom[ch][x];
+    if (prev_top == top && prev_bottom == bottom)
+        return;
+
+    hwave.top[ch][x] = top;
+    hwave.bottom[ch][x] = bottom;
+    if (prev_top != WAVEFORM_NO_SPAN)
+        _waveform_compose(x, prev_top, prev_bottom);
+    if (top != WAVEFORM_NO_SPAN)
+        _waveform_compose(x, top, bottom);
+}
+
+void waveform_init(void) {
+    hwave.width = LCD_WIDTH;
+    hwave.height = CHART_HEIGHT;
+    for (size_t i = 0U; i < WAVEFORM_PALETTE_SIZE; ++i)
+        hwave.palette[i] = WAVEFORM_TRANSPARENT;
+    _waveform_reset();
+}
+
+HAL_StatusTypeDef waveform_set_size(size_t width, size_t height) {
+    if (width == 0U || height == 0U || width > LCD_WIDTH || width * height > CHART_WAVEFORM_PIXEL_COUNT)
+        return HAL_ERROR;
+    hwave.width = width;
+    hwave.height = height;
+    _waveform_reset();
+    return HAL_OK;
+}
+
+void waveform_set_color(ChartHandlerChannel ch, uint32_t color) {
+    if (ch >= CHART_HANDLER_CHANNEL_COUNT)
+        return;
+    hwave.palette[WAVEFORM_INDEX_CHANNEL + ch] = _waveform_opaque(color & 0x00FFFFFFU);
+
+    // Each intensity level scales the channel color as if it was blended over black
+    uint32_t * levels = &hwave.palette[WAVEFORM_INDEX_PERSISTENCE + ch * WAVEFORM_PERSISTENCE_LEVEL_COUNT];
+    const uint32_t r = (color >> 16U) & 0xFFU;
+    const uint32_t g = (color >> 8U) & 0xFFU;
+    const uint32_t b = color & 0xFFU;
+    levels[0U] = WAVEFORM_TRANSPARENT;
+    for (uint32_t level = 1U; level < WAVEFORM_PERSISTENCE_LEVEL_COUNT; ++level) {
+        const uint32_t scaled =
+            ((r * level / (WAVEFORM_PERSISTENCE_LEVEL_COUNT - 1U)) << 16U) |
+            ((g * level / (WAVEFORM_PERSISTENCE_LEVEL_COUNT - 1U)) << 8U) |
+            (b * level / (WAVEFORM_PERSISTENCE_LEVEL_COUNT - 1U));
+        levels[level] = _waveform_opaque(scaled);
+    }
+}
+
+uint32_t * waveform_get_palette(void) {
+    return hwave.palette;
+}
+
+uint8_t * waveform_get_buffer(void) {
+    return waveform_data;
+}
+
+const int16_t * waveform_get_top(ChartHandlerChannel ch) {
+    return hwave.top[ch];
+}
+
+const int16_t * waveform_get_bottom(ChartHandlerChannel ch) {
+    return hwave.bottom[ch];
+}
+
+size_t waveform_get_width(void) {
+    return hwave.width;
+}
+
+size_t waveform_get_height(void) {
+    return hwave.height;
+}
+
+void waveform_refresh(void) {
+    // Only the pixels whose persistence intensity changed are composed again, row by row
+    // The unchanged columns have both rows set to PERSISTENCE_NO_ROW so no row is inside them
+    const int16_t * top = persistence_get_changed_top();
+    const int16_t * bottom = persistence_get_changed_bottom();
+    int16_t first, last;
+    persistence_get_changed_rows(&first, &last);
+    if (last >= (int32_t)hwave.height)
+        last = (int16_t)(hwave.height - 1U);
+    for (int32_t row = first < 0 ? 0 : first; row <= last; ++row) {
+        uint8_t * line = &waveform_data[row * hwave.width];
+        for (size_t x = 0U; x < hwave.width; ++x) {
+            if (row >= top[x] && row <= bottom[x])
+                line[x] = _waveform_pixel(x, row);
+        }
+    }
+    persistence_reset_changes();
+}
+
+void waveform_clear(ChartHandlerChannel ch) {
+    if (ch >= CHART_HANDLER_CHANNEL_COUNT)
+        return;
+    for (size_t x = 0U; x < hwave.width; ++x)
+        _waveform_set_span(ch, x, WAVEFORM_NO_SPAN, WAVEFORM_NO_SPAN);
+}
+
+void waveform_draw(
+    ChartHandlerChannel ch,
+    const int16_t * values,
+    const int16_t * min_values,
+    size_t count,
+    int32_t range)
+{
+    if (ch >= CHART_HANDLER_CHANNEL_COUNT || values == NULL || count == 0U || range <= 0)
+        return;
+
+    const int32_t last = (int32_t)hwave.height - 1;
+    const size_t columns = hwave.width > 1U ? hwave.width - 1U : 1U;
+    bool joined = false;
+    int32_t prev = 0;
+    for (size_t x = 0U; x < hwave.width; ++x) {
+        // Position of the column between two consecutive values
+        // The peaks are not interpolated so the column takes the nearest value
+        size_t pos = ((x * (count - 1U)) << WAVEFORM_FRACTION_BITS) / columns;
+        if (min_values != NULL)
+            pos += 1U << (WAVEFORM_FRACTION_BITS - 1U);
+        const size_t i = pos >> WAVEFORM_FRACTION_BITS;
+        const int32_t frac = (int32_t)(pos & ((1U << WAVEFORM_FRACTION_BITS) - 1U));
+
+        if (values[i] == CHART_HANDLER_POINT_NONE) {
+            _waveform_set_span(ch, x, WAVEFORM_NO_SPAN, WAVEFORM_NO_SPAN);
+            joined = false;
+            continue;
+        }
+
+        int32_t high = values[i];
+        int32_t low = high;
+        if (min_values != NULL) {
+            if (min_values[i] != CHART_HANDLER_POINT_NONE)
+                low = min_values[i] < high ? min_values[i] : high;
+        }
+        else if (i + 1U < count && values[i + 1U] != CHART_HANDLER_POINT_NONE) {
+            high += ((values[i + 1U] - high) * frac) >> WAVEFORM_FRACTION_BITS;
+            low = high;
+        }
+
+        // The rows start from the top of the area
+        int32_t top = _waveform_to_row(high, range);
+        int32_t bottom = _waveform_to_row(low, range);
+        const int32_t row = (top + bottom) / 2;
+
+        // Join the column to the previous one
+        if (joined) {
+            if (prev < top)
+                top = prev;
+            if (prev > bottom)
+                bottom = prev;
+        }
+        joined = true;
+        prev = row;
+
+        // Only the part of the span inside the area is drawn
+        if (bottom < 0 || top > last) {
+            _waveform_set_span(ch, x, WAVEFORM_NO_SPAN, WAVEFORM_NO_SPAN);
+            continue;
+        }
+        if (top < 0)
+            top = 0;
+        if (bottom > last)
+            bottom = last;
+        _waveform_set_span(ch, x, (int16_t)top, (int16_t)bottom);
+    }
+}
@@ -0,0 +1,30 @@
+/**
+ * @file shared.h
+ * @brief Data shared between the two cores
+ *
+ * @date Oct 16, 2026
+ * @author Antonio Gelain [antonio.gelain@studenti.unitn.it]
+ */
+
+#ifndef SHARED_H
+#define SHARED_H
+
+#include <stdint.h>
+
+/**
+ * @brief D3 SRAM (SRAM4) info, reachable by both cores
+ *
+ * @details The whole SRAM4 is not cacheable on the CM7 (see MPU_Config), so the values
+ * written by one core are seen right away by the other one
+ */
+#define SHARED_RAM_ADDRESS (0x38000000U)
+#define SHARED_RAM_SIZE (64U * 1024U)
+
+/** @brief Address of the data shared between the two cores */
+#define SHARED_DATA_ADDRESS (SHARED_RAM_ADDRESS + 0x1000U)
+
+struct _shared {
+	uint32_t generator_index;
+};
+
+#endif  // SHARED_H